@@ -0,0 +1,175 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim/batch.h"
+#include "sim/logging.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] [-c scenariofile] [-f floors] [-e elevators] [-r requests] "
+        "[-t maxticks] [-n runs] [-s seed] [-w pattern] [-l rate] [-d dispatch] "
+        "[-k capacity] [-j threads] [-p]\n",
+        appname);
+    printf("  -c: Read scenarios from a file, one per line:\n"
+        "      'floors elevators requests maxticks seed'\n"
+        "  -n: Without -c, run this many scenarios using -f/-e/-r/-t,\n"
+        "      with seeds counting up from -s\n"
+        "  -w: Traffic pattern for all scenarios:\n"
+        "      inter-floor, up-peak, down-peak or lunch\n"
+        "  -l: Average requests arriving per tick, may be fractional\n"
+        "  -d: Pickup dispatch for all scenarios:\n"
+        "      fewest, eta, batch or rollout\n"
+        "  -k: Passenger mode, where identical requests aren't merged and\n"
+        "      each elevator carries at most this many, or any number if 0\n"
+        "  -j: Worker threads, or 0 for one per core\n"
+        "  -p: Print the result of every run\n");
+  }
+
+  bool read_scenarios(const char *path, const sim::Scenario &base,
+      std::vector<sim::Scenario> &scenarios) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+      fprintf(stderr, "Unable to open scenario file %s\n", path);
+      return false;
+    }
+    char line[256];
+    size_t line_num = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+      ++line_num;
+      if (line[0] == '#' || line[0] == '\n') {
+        continue;
+      }
+      sim::Scenario scenario = base;
+      unsigned long long seed;
+      if (sscanf(line, "%lu %lu %lu %lu %llu", &scenario.floors,
+              &scenario.elevators, &scenario.requests, &scenario.max_ticks,
+              &seed) != 5) {
+        fprintf(stderr, "Invalid scenario on line %lu of %s\n", line_num, path);
+        fclose(file);
+        return false;
+      }
+      scenario.seed = seed;
+      scenarios.push_back(scenario);
+    }
+    fclose(file);
+    return true;
+  }
+}
+
+/**
+ * Runs many independent scenarios across all cores, printing aggregate
+ * results.
+ */
+int main(int argc, char *argv[]) {
+  const char *scenario_path = NULL;
+  sim::Scenario base;
+  size_t run_count = 100;
+  size_t thread_count = 0;
+  bool print_runs = false;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "hc:f:e:r:t:n:s:w:l:d:k:j:p")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'c':
+        scenario_path = optarg;
+        break;
+      case 'f':
+        base.floors = atoi(optarg);
+        break;
+      case 'e':
+        base.elevators = atoi(optarg);
+        break;
+      case 'r':
+        base.requests = atoi(optarg);
+        break;
+      case 't':
+        base.max_ticks = atoi(optarg);
+        break;
+      case 'n':
+        run_count = atoi(optarg);
+        break;
+      case 's':
+        base.seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'w':
+        if (!sim::parse_pattern(optarg, base.pattern)) {
+          fprintf(stderr, "Unknown pattern: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'l':
+        base.rate = atof(optarg);
+        break;
+      case 'd':
+        if (!sim::parse_dispatch(optarg, base.dispatch)) {
+          fprintf(stderr, "Unknown dispatch: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'k':
+        base.passengers = true;
+        base.capacity = atoi(optarg);
+        break;
+      case 'j':
+        thread_count = atoi(optarg);
+        break;
+      case 'p':
+        print_runs = true;
+        break;
+    }
+  }
+
+  std::vector<sim::Scenario> scenarios;
+  if (scenario_path != NULL) {
+    if (!read_scenarios(scenario_path, base, scenarios)) {
+      return 1;
+    }
+  } else {
+    for (size_t i = 0; i < run_count; ++i) {
+      sim::Scenario scenario = base;
+      scenario.seed = base.seed + i;
+      scenarios.push_back(scenario);
+    }
+  }
+
+  sim::verbose_enabled = false;
+  sim::BatchRunner runner(thread_count);
+  sim::BatchResult result = runner.run(scenarios);
+
+  if (print_runs) {
+    printf("run,floors,elevators,requests,seed,inserted,completed,ticks\n");
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+      const sim::Scenario &scenario = scenarios[i];
+      const sim::RunResult &run = result.runs[i];
+      printf("%lu,%lu,%lu,%lu,%llu,%lu,%d,%lu\n", i, scenario.floors,
+          scenario.elevators, scenario.requests,
+          (unsigned long long)scenario.seed, run.inserted, run.completed,
+          run.ticks);
+    }
+  }
+  printf("%lu/%lu runs completed. Ticks to drain: min=%lu mean=%.1f max=%lu\n",
+      result.completed, scenarios.size(), result.min_ticks, result.mean_ticks,
+      result.max_ticks);
+  const sim::Histogram &wait = result.latency.wait;
+  printf("Wait ticks: mean=%.1f p50=%lu p99=%lu p999=%lu max=%lu\n",
+      wait.mean(), wait.percentile(50), wait.percentile(99),
+      wait.percentile(99.9), wait.max());
+  if (sim::PhaseTimings::enabled()) {
+    const sim::PhaseTimings &phases = result.phases;
+    for (int i = 0; i < sim::PHASE_COUNT; ++i) {
+      sim::Phase phase = sim::Phase(i);
+      printf("Phase %s: total=%llu%s sections=%llu mean=%.1f%s\n",
+          sim::string(phase), (unsigned long long)phases.time(phase),
+          sim::PhaseTimings::unit(), (unsigned long long)phases.count(phase),
+          phases.count(phase) ? double(phases.time(phase)) / phases.count(phase)
+            : 0.0,
+          sim::PhaseTimings::unit());
+    }
+  }
+  return (result.completed == scenarios.size()) ? 0 : 2;
+}
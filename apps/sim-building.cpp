@@ -0,0 +1,124 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "sim/building.h"
+#include "sim/logging.h"
+#include "sim/random.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] [-f floors] [-z zones] [-e elevators] [-r requests] "
+        "[-p pertick] [-t maxticks] [-s seed] [-d dispatch] [-j threads]\n",
+        appname);
+    printf("  -z: Number of zones, joined by sky lobbies\n"
+        "  -e: Elevators in each zone\n"
+        "  -r: Ticks with random requests, before draining\n"
+        "  -p: Random requests inserted on each of those ticks\n"
+        "  -d: Pickup dispatch in every zone:\n"
+        "      fewest, eta, batch or rollout\n"
+        "  -j: Threads to run zones on, or 0 for one per core\n");
+  }
+}
+
+/**
+ * Runs random trips through a tall building which is split into zones, and
+ * prints trip latencies and speed.
+ */
+int main(int argc, char *argv[]) {
+  sim::floor_t floor_count = 300;
+  size_t zone_count = 6;
+  size_t elevator_count = 32;
+  size_t request_ticks = 1000;
+  size_t per_tick = 4;
+  size_t total_tick_max = 100000;
+  uint64_t seed = 0;
+  sim::Dispatch dispatch = sim::FEWEST_REQUESTS;
+  size_t thread_count = 1;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "hf:z:e:r:p:t:s:d:j:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'f':
+        floor_count = atoi(optarg);
+        break;
+      case 'z':
+        zone_count = atoi(optarg);
+        break;
+      case 'e':
+        elevator_count = atoi(optarg);
+        break;
+      case 'r':
+        request_ticks = atoi(optarg);
+        break;
+      case 'p':
+        per_tick = atoi(optarg);
+        break;
+      case 't':
+        total_tick_max = atoi(optarg);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'd':
+        if (!sim::parse_dispatch(optarg, dispatch)) {
+          fprintf(stderr, "Unknown dispatch: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'j':
+        thread_count = atoi(optarg);
+        break;
+    }
+  }
+  std::vector<sim::ZoneConfig> zones =
+    sim::split_zones(floor_count, zone_count, elevator_count);
+  if (floor_count < 2 || zones.empty() || elevator_count == 0) {
+    fprintf(stderr, "Need at least 2 floors and 1 elevator\n");
+    return 1;
+  }
+
+  sim::verbose_enabled = false;
+  sim::Building building(zones, thread_count);
+  for (size_t i = 0; i < building.zone_count(); ++i) {
+    building.zone(i).set_dispatch(dispatch);
+  }
+  sim::Random random(seed);
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  for (size_t tick = 0; tick < request_ticks; ++tick) {
+    for (size_t i = 0; i < per_tick; ++i) {
+      sim::floor_t source = random.below(floor_count);
+      // Avoid having dest == source by skipping over the source floor.
+      sim::floor_t dest = random.below(floor_count - 1);
+      if (dest >= source) {
+        ++dest;
+      }
+      building.insert_request(source, dest);
+    }
+    building.tick();
+  }
+  while (!building.idle() && building.tick_count() < total_tick_max) {
+    building.tick();
+  }
+
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  printf("%lu zones of %lu elevators over %lu floors\n",
+      building.zone_count(), elevator_count, building.floors());
+  printf("%s after %lu ticks in %.3fs (%.0f ticks/s), %lu transfers\n",
+      building.idle() ? "Completed" : "Still busy", building.tick_count(),
+      elapsed, building.tick_count() / elapsed, building.transfers());
+  const sim::Histogram &trip = building.trip_latency();
+  printf("Trip ticks: mean=%.1f p50=%lu p99=%lu p999=%lu max=%lu "
+      "(%lu trips)\n", trip.mean(), trip.percentile(50), trip.percentile(99),
+      trip.percentile(99.9), trip.max(), trip.count());
+  return building.idle() ? 0 : 2;
+}
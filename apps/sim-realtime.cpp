@@ -0,0 +1,140 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "sim/logging.h"
+#include "sim/random.h"
+#include "sim/realtime.h"
+#include "sim/request_queue.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] [-f floors] [-e elevators] [-t ticks] [-p periodms] "
+        "[-c core] [-n producers] [-r rate] [-d dispatch]\n", appname);
+    printf("  -p: Wall-clock milliseconds per tick\n"
+        "  -c: Pin the tick thread to this CPU core\n"
+        "  -n: Threads submitting requests, like hall call panels\n"
+        "  -r: Requests per second from each producer thread\n");
+  }
+
+  void print_micros(const char *name, const sim::Histogram &histogram) {
+    printf("%s us: p50 %.1f, p99 %.1f, p999 %.1f, max %.1f\n", name,
+        histogram.percentile(50) / 1e3, histogram.percentile(99) / 1e3,
+        histogram.percentile(99.9) / 1e3, histogram.max() / 1e3);
+  }
+}
+
+/**
+ * Runs a scheduler in step with the wall clock while other threads submit
+ * random requests, and reports how well each tick kept to its deadline.
+ */
+int main(int argc, char *argv[]) {
+  sim::floor_t floor_count = 50;
+  size_t elevator_count = 16;
+  size_t tick_count = 1000;
+  double period_ms = 10;
+  int core = -1;
+  size_t producer_count = 4;
+  double rate = 20;
+  sim::Dispatch dispatch = sim::FEWEST_REQUESTS;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "hf:e:t:p:c:n:r:d:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'f':
+        floor_count = atoi(optarg);
+        break;
+      case 'e':
+        elevator_count = atoi(optarg);
+        break;
+      case 't':
+        tick_count = atoi(optarg);
+        break;
+      case 'p':
+        period_ms = atof(optarg);
+        break;
+      case 'c':
+        core = atoi(optarg);
+        break;
+      case 'n':
+        producer_count = atoi(optarg);
+        break;
+      case 'r':
+        rate = atof(optarg);
+        break;
+      case 'd':
+        if (!sim::parse_dispatch(optarg, dispatch)) {
+          fprintf(stderr, "Unknown dispatch: %s\n", optarg);
+          exit(1);
+        }
+        break;
+    }
+  }
+  if (floor_count < 2 || producer_count == 0 || rate <= 0) {
+    fprintf(stderr, "Need at least 2 floors, 1 producer and a positive rate\n");
+    return 1;
+  }
+
+  sim::verbose_enabled = false;
+  sim::Scheduler scheduler(floor_count, elevator_count);
+  scheduler.set_dispatch(dispatch);
+  sim::RequestQueue queue(producer_count);
+  scheduler.set_request_queue(&queue);
+
+  // Each producer presses random buttons at a steady rate until the run ends.
+  std::atomic<bool> done(false);
+  std::atomic<size_t> submitted(0);
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < producer_count; ++i) {
+    producers.emplace_back([&queue, &done, &submitted, i, floor_count, rate]() {
+      sim::RequestQueue::Producer producer = queue.producer(i);
+      sim::Random random(i);
+      std::chrono::duration<double> interval(1 / rate);
+      std::chrono::steady_clock::time_point next =
+        std::chrono::steady_clock::now();
+      while (!done.load()) {
+        sim::floor_t source = random.below(floor_count);
+        sim::floor_t dest = random.below(floor_count - 1);
+        if (dest >= source) {
+          ++dest;
+        }
+        if (producer.submit(source, dest)) {
+          ++submitted;
+        }
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            interval);
+        std::this_thread::sleep_until(next);
+      }
+    });
+  }
+
+  if (core >= 0 && !sim::pin_current_thread(core)) {
+    fprintf(stderr, "Unable to pin the tick thread to core %d\n", core);
+  }
+  sim::RealtimeDriver driver(scheduler, period_ms * 1e6);
+  size_t ran = driver.run(tick_count);
+  done.store(true);
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+
+  printf("Ran %lu ticks of %.3fms: %lu requests submitted, %lu dropped\n",
+      ran, period_ms, submitted.load(), queue.dropped());
+  print_micros("Tick duration", driver.tick_durations());
+  print_micros("Start lateness", driver.start_lateness());
+  const std::vector<sim::DeadlineMiss> &misses = driver.misses();
+  printf("%lu deadline misses\n", misses.size());
+  for (size_t i = 0; i < misses.size() && i < 10; ++i) {
+    printf("  tick %lu: started %.1fus late, ran %.1fus\n", misses[i].tick,
+        misses[i].lateness_ns / 1e3, misses[i].duration_ns / 1e3);
+  }
+  return misses.empty() ? 0 : 2;
+}
@@ -0,0 +1,252 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim/trace.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] [-t tick] trace [other_trace]\n", appname);
+    printf("  With one trace: Print a summary, or the state at the end of -t.\n"
+        "  With two traces: Find the first tick where their state hashes\n"
+        "  differ, and the first record where they differ.\n");
+  }
+
+  const char *type_string(uint8_t type) {
+    switch (type) {
+      case sim::TRACE_REQUEST: return "Request";
+      case sim::TRACE_PICKUP: return "Pickup";
+      case sim::TRACE_DROPOFF: return "Dropoff";
+      case sim::TRACE_ACTION: return "Action";
+      case sim::TRACE_SKIP: return "Skip";
+      case sim::TRACE_HASH: return "Hash";
+    }
+    return "?";
+  }
+
+  uint64_t record_hash(const sim::TraceRecord &record) {
+    return (uint64_t(record.b) << 32) | record.a;
+  }
+
+  void print_record(const char *label, const sim::TraceRecord &record) {
+    printf("  %s: tick=%lu %s", label, (unsigned long)record.tick,
+        type_string(record.type));
+    switch (record.type) {
+      case sim::TRACE_REQUEST:
+        printf(" source=%u dest=%u\n", record.a, record.b);
+        break;
+      case sim::TRACE_PICKUP:
+      case sim::TRACE_DROPOFF:
+        printf(" elevator=%u floor=%u direction=%s\n", record.elevator,
+            record.a, sim::string(sim::Direction(record.b)));
+        break;
+      case sim::TRACE_ACTION:
+        printf(" elevator=%u floor=%u action=%s\n", record.elevator,
+            record.a, sim::string(sim::Action(record.b)));
+        break;
+      case sim::TRACE_SKIP:
+        printf(" ticks=%u\n", record.a);
+        break;
+      case sim::TRACE_HASH:
+        printf(" hash=%016llx\n", (unsigned long long)record_hash(record));
+        break;
+      default:
+        printf("\n");
+        break;
+    }
+  }
+
+  void print_floors(const sim::FloorSet &floors) {
+    for (sim::floor_t floor : floors) {
+      printf(" %lu", floor);
+    }
+  }
+
+  int summary(const sim::TraceReader &trace) {
+    size_t counts[sim::TRACE_HASH + 1] = {0};
+    for (size_t i = 0; i < trace.size(); ++i) {
+      uint8_t type = trace[i].type;
+      if (type <= sim::TRACE_HASH) {
+        ++counts[type];
+      }
+    }
+    printf("Trace of %lu floors, %lu elevators: %lu records",
+        (unsigned long)trace.header().floors,
+        (unsigned long)trace.header().elevators, trace.size());
+    if (trace.size() != 0) {
+      printf(" over ticks %lu-%lu", (unsigned long)trace[0].tick,
+          (unsigned long)trace[trace.size() - 1].tick);
+    }
+    printf("\n");
+    for (uint8_t type = sim::TRACE_REQUEST; type <= sim::TRACE_HASH; ++type) {
+      printf("  %s: %lu\n", type_string(type), counts[type]);
+    }
+    return 0;
+  }
+
+  int state_at(const sim::TraceReader &trace, uint64_t tick) {
+    sim::TraceState state(trace.header().floors, trace.header().elevators);
+    size_t end = trace.find(tick + 1);
+    const sim::TraceRecord *hash = NULL;
+    for (size_t i = 0; i < end; ++i) {
+      if (!state.apply(trace[i])) {
+        fprintf(stderr, "Record %lu doesn't match the replayed state:\n", i);
+        print_record("record", trace[i]);
+        return 2;
+      }
+      if (trace[i].type == sim::TRACE_HASH) {
+        hash = &trace[i];
+      }
+    }
+    printf("State at end of tick %lu", (unsigned long)tick);
+    if (hash != NULL) {
+      printf(" (hash %016llx as of tick %lu)",
+          (unsigned long long)record_hash(*hash), (unsigned long)hash->tick);
+    }
+    printf(":\n");
+    for (size_t i = 0; i < state.elevators.size(); ++i) {
+      sim::Elevator &elevator = state.elevators[i];
+      printf("  Elevator %lu: floor[%lu] direction[%s] requests[%lu]", i,
+          elevator.floor(), sim::string(elevator.direction()),
+          elevator.request_count());
+      printf("\n");
+    }
+    for (sim::floor_t floor = 0; floor < state.up_requests.size(); ++floor) {
+      const sim::FloorSet &up = state.up_requests[floor];
+      const sim::FloorSet &down = state.down_requests[floor];
+      if (up.empty() && down.empty()) {
+        continue;
+      }
+      printf("  Pickup floor %lu:", floor);
+      if (!up.empty()) {
+        printf(" up%s[", state.up_accepted.contains(floor) ? "(accepted)" : "");
+        print_floors(up);
+        printf(" ]");
+      }
+      if (!down.empty()) {
+        printf(" down%s[",
+            state.down_accepted.contains(floor) ? "(accepted)" : "");
+        print_floors(down);
+        printf(" ]");
+      }
+      printf("\n");
+    }
+    return 0;
+  }
+
+  /**
+   * Returns the index of the next TRACE_HASH record at or after 'i', or the
+   * size of the trace if there isn't one.
+   */
+  size_t next_hash(const sim::TraceReader &trace, size_t i) {
+    while (i < trace.size() && trace[i].type != sim::TRACE_HASH) {
+      ++i;
+    }
+    return i;
+  }
+
+  /**
+   * Compares the state hashes of two traces at every tick which both of them
+   * hashed. Since the hash covers the state rather than the order that
+   * things happened in, this finds where two implementations made different
+   * decisions, even if they record their events in different orders. Returns
+   * false if they diverge.
+   */
+  bool diff_hashes(const sim::TraceReader &a, const sim::TraceReader &b) {
+    size_t compared = 0;
+    size_t i = next_hash(a, 0), j = next_hash(b, 0);
+    while (i < a.size() && j < b.size()) {
+      const sim::TraceRecord &ra = a[i], &rb = b[j];
+      if (ra.tick < rb.tick) {
+        i = next_hash(a, i + 1);
+      } else if (rb.tick < ra.tick) {
+        j = next_hash(b, j + 1);
+      } else {
+        if (ra.a != rb.a || ra.b != rb.b) {
+          printf("States diverge at tick %lu, after matching at %lu ticks:\n",
+              (unsigned long)ra.tick, compared);
+          print_record("first", ra);
+          print_record("second", rb);
+          return false;
+        }
+        ++compared;
+        i = next_hash(a, i + 1);
+        j = next_hash(b, j + 1);
+      }
+    }
+    if (compared == 0) {
+      printf("No state hashes to compare\n");
+    } else {
+      printf("States match at all %lu hashed ticks\n", compared);
+    }
+    return true;
+  }
+
+  int diff(const sim::TraceReader &a, const sim::TraceReader &b) {
+    if (a.header().floors != b.header().floors
+        || a.header().elevators != b.header().elevators) {
+      printf("Traces have different dimensions\n");
+      return 1;
+    }
+    bool hashes_match = diff_hashes(a, b);
+    size_t count = (a.size() < b.size()) ? a.size() : b.size();
+    for (size_t i = 0; i < count; ++i) {
+      const sim::TraceRecord &ra = a[i], &rb = b[i];
+      if (ra.tick != rb.tick || ra.type != rb.type
+          || ra.elevator != rb.elevator || ra.a != rb.a || ra.b != rb.b) {
+        printf("Traces diverge at record %lu, tick %lu:\n", i,
+            (unsigned long)((ra.tick < rb.tick) ? ra.tick : rb.tick));
+        print_record("first", ra);
+        print_record("second", rb);
+        return 1;
+      }
+    }
+    if (a.size() != b.size()) {
+      printf("Traces match for %lu records, then one ends\n", count);
+      return 1;
+    }
+    printf("Traces match (%lu records)\n", count);
+    return hashes_match ? 0 : 1;
+  }
+}
+
+/**
+ * Inspects traces recorded via Scheduler::set_trace().
+ */
+int main(int argc, char *argv[]) {
+  bool have_tick = false;
+  uint64_t tick = 0;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "ht:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 't':
+        have_tick = true;
+        tick = strtoull(optarg, NULL, 10);
+        break;
+    }
+  }
+  if (optind == argc || argc - optind > 2) {
+    syntax(argv[0]);
+    return 1;
+  }
+
+  sim::TraceReader first;
+  if (!first.open(argv[optind])) {
+    fprintf(stderr, "Unable to read trace %s\n", argv[optind]);
+    return 1;
+  }
+  if (argc - optind == 2) {
+    sim::TraceReader second;
+    if (!second.open(argv[optind + 1])) {
+      fprintf(stderr, "Unable to read trace %s\n", argv[optind + 1]);
+      return 1;
+    }
+    return diff(first, second);
+  }
+  return have_tick ? state_at(first, tick) : summary(first);
+}
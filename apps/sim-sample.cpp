@@ -4,19 +4,31 @@
 
 #include "sim/scheduler.h"
 #include "sim/logging.h"
+#include "sim/trace.h"
+#include "sim/traffic.h"
+#include "sim/workload.h"
 
 namespace {
   void syntax(char* appname) {
-    printf("%s [-h] [-f floors] [-e elevators] [-r requests] [-t maxticks]\n", appname);
+    printf("%s [-h] [-f floors] [-e elevators] [-r requests] [-t maxticks] "
+        "[-o tracefile] [-w workload] [-d dispatch] [-p pattern] [-l rate] "
+        "[-s seed] [-H]\n", appname);
   }
 
   void parse_config(int argc, char *argv[],
       sim::floor_t &floor_count,
       size_t &elevator_count,
       size_t &request_count,
-      size_t &total_tick_max) {
+      size_t &total_tick_max,
+      const char *&trace_path,
+      const char *&workload_path,
+      sim::Dispatch &dispatch,
+      sim::Pattern &pattern,
+      double &rate,
+      uint64_t &seed,
+      bool &hash_check) {
     int opt = 0;
-    while ((opt = getopt(argc, argv, "hf:e:r:t:")) != -1) {
+    while ((opt = getopt(argc, argv, "hf:e:r:t:o:w:d:p:l:s:H")) != -1) {
       switch (opt) {
         case 'h':
           syntax(argv[0]);
@@ -34,6 +46,33 @@ namespace {
         case 't':
           total_tick_max = atoi(optarg);
           break;
+        case 'o':
+          trace_path = optarg;
+          break;
+        case 'w':
+          workload_path = optarg;
+          break;
+        case 'd':
+          if (!sim::parse_dispatch(optarg, dispatch)) {
+            fprintf(stderr, "Unknown dispatch: %s\n", optarg);
+            exit(1);
+          }
+          break;
+        case 'p':
+          if (!sim::parse_pattern(optarg, pattern)) {
+            fprintf(stderr, "Unknown pattern: %s\n", optarg);
+            exit(1);
+          }
+          break;
+        case 'l':
+          rate = atof(optarg);
+          break;
+        case 's':
+          seed = strtoull(optarg, NULL, 10);
+          break;
+        case 'H':
+          hash_check = true;
+          break;
       }
     }
     printf("\n");
@@ -41,6 +80,12 @@ namespace {
     printf("Args: floors(-f)=%lu elevators(-e)=%lu requests(-r)=%lu maxticks(-t)=%lu\n\n",
         floor_count, elevator_count, request_count, total_tick_max);
   }
+
+  void print_latency(const char *name, const sim::Histogram &histogram) {
+    printf("%s ticks: p50 %lu, p99 %lu, p999 %lu, max %lu (%lu requests)\n",
+        name, histogram.percentile(50), histogram.percentile(99),
+        histogram.percentile(99.9), histogram.max(), histogram.count());
+  }
 }
 
 /**
@@ -52,22 +97,52 @@ int main(int argc, char *argv[]) {
   size_t elevator_count = 16;
   size_t request_count = 1000;
   size_t total_tick_max = 10000;
-  parse_config(argc, argv, floor_count, elevator_count, request_count, total_tick_max);
+  const char *trace_path = NULL;
+  const char *workload_path = NULL;
+  sim::Dispatch dispatch = sim::FEWEST_REQUESTS;
+  sim::Pattern pattern = sim::INTER_FLOOR;
+  double rate = 1;
+  uint64_t seed = 0;
+  bool hash_check = false;
+  parse_config(argc, argv, floor_count, elevator_count, request_count,
+      total_tick_max, trace_path, workload_path, dispatch, pattern, rate,
+      seed, hash_check);
+
+  // Requests come from the workload file if there is one, or are generated.
+  std::unique_ptr<sim::RequestSource> workload;
+  if (workload_path != NULL) {
+    workload = sim::open_request_source(workload_path);
+    if (!workload) {
+      fprintf(stderr, "Unable to open workload %s\n", workload_path);
+      return 1;
+    }
+  } else if (floor_count >= 2 && request_count > 0) {
+    workload.reset(new sim::TrafficGenerator(
+            floor_count, pattern, rate, seed, request_count));
+  }
 
   sim::verbose_enabled = true;
   sim::Scheduler scheduler(floor_count, elevator_count);
+  scheduler.set_dispatch(dispatch);
+  scheduler.set_hash_check(hash_check);
+  sim::TraceWriter trace;
+  if (trace_path != NULL) {
+    if (!trace.open(trace_path, floor_count, elevator_count)) {
+      fprintf(stderr, "Unable to create trace %s\n", trace_path);
+      return 1;
+    }
+    scheduler.set_trace(&trace);
+  }
 
   size_t ticks_elapsed = 0;
-  // Input random requests, incrementing steps as we add them.
-  for (; ticks_elapsed < request_count; ++ticks_elapsed) {
-    sim::floor_t source = rand() % floor_count;
-    sim::floor_t dest;
-    do {
-      // Avoid having dest == source. The scheduler will reject these.
-      dest = rand() % floor_count;
-    } while (source == dest);
-    scheduler.insert_request(source, dest);
-    scheduler.tick();
+  request_count = 0;
+  if (workload) {
+    // Input requests as their ticks come up.
+    sim::RequestFeeder feeder(*workload);
+    for (; !feeder.done() && ticks_elapsed < total_tick_max; ++ticks_elapsed) {
+      request_count += feeder.insert_due(scheduler);
+      scheduler.tick();
+    }
   }
   for (; ticks_elapsed < total_tick_max; ++ticks_elapsed) {
     if (scheduler.idle()) {
@@ -75,12 +150,25 @@ int main(int argc, char *argv[]) {
     }
     scheduler.tick();
   }
+  sim::flush_log();
+  if (trace_path != NULL && !trace.close()) {
+    fprintf(stderr, "Unable to write trace %s\n", trace_path);
+  }
   if (scheduler.idle()) {
     printf("\nSimulation completed successfully in %lu ticks: "
         "%lu elevators on %lu floors with %lu requests.\n\n",
         ticks_elapsed, elevator_count, floor_count, request_count);
+    print_latency("Wait", scheduler.latency().wait);
+    print_latency("Travel", scheduler.latency().travel);
+    printf("State hash: %016llx\n\n",
+        (unsigned long long)scheduler.state_hash());
   } else {
     fprintf(stderr, "\nWarning!: Scheduler still busy after %lu ticks!\n\n",
         total_tick_max);
   }
+  if (scheduler.hash_mismatch_tick() != 0) {
+    fprintf(stderr, "Error: State hash didn't match the state at tick %lu\n",
+        scheduler.hash_mismatch_tick());
+    return 2;
+  }
 }
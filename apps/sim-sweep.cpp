@@ -0,0 +1,278 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "sim/logging.h"
+#include "sim/sweep.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] -o resultfile [-R] [-f floors] [-e elevators] "
+        "[-w patterns] [-l rates] [-d dispatches] [-n seeds] [-s seed] "
+        "[-r requests] [-t maxticks] [-k capacity] [-j threads]\n"
+        "%s -i resultfile\n",
+        appname, appname);
+    printf("  -o: Results file to write, in the columnar format from\n"
+        "      sim/sweep.h\n"
+        "  -R: Resume the sweep in an existing results file, skipping the\n"
+        "      runs that are done. The grid must be the same as before\n"
+        "  -f/-e/-l: Comma-separated values to sweep, each a number or a\n"
+        "      range 'first:last' or 'first:last:step'\n"
+        "  -w/-d: Comma-separated patterns (inter-floor, up-peak, down-peak,\n"
+        "      lunch) or dispatches (fewest, eta, batch, rollout) to sweep\n"
+        "  -n: Seeds to run at each point, counting up from -s\n"
+        "  -k: Passenger mode, where each elevator carries at most this\n"
+        "      many passengers, or any number if 0\n"
+        "  -j: Worker threads, or 0 for one per core\n"
+        "  -i: Print a results file as CSV\n");
+  }
+
+  /**
+   * Parses a comma-separated list of numbers and ranges into 'values'.
+   * Returns false if it's malformed.
+   */
+  bool parse_numbers(const char *list, std::vector<double> &values) {
+    values.clear();
+    const char *pos = list;
+    while (*pos != '\0') {
+      char *end;
+      double first = strtod(pos, &end), last = first, step = 1;
+      if (end == pos) {
+        return false;
+      }
+      if (*end == ':') {
+        pos = end + 1;
+        last = strtod(pos, &end);
+        if (end == pos) {
+          return false;
+        }
+        if (*end == ':') {
+          pos = end + 1;
+          step = strtod(pos, &end);
+          if (end == pos || !(step > 0)) {
+            return false;
+          }
+        }
+      }
+      // Count in steps rather than summing them, so fractional steps don't
+      // pile up rounding errors.
+      for (size_t i = 0; first + i * step <= last + step * 1e-9; ++i) {
+        values.push_back(first + i * step);
+      }
+      if (*end == ',') {
+        ++end;
+      } else if (*end != '\0') {
+        return false;
+      }
+      pos = end;
+    }
+    return !values.empty();
+  }
+
+  /**
+   * Parses a comma-separated list of names into 'values', using the provided
+   * parser for each one. Returns false if any name isn't recognized.
+   */
+  template <typename T>
+  bool parse_names(const char *list, bool (*parse)(const char*, T&),
+      std::vector<T> &values) {
+    values.clear();
+    char name[64];
+    const char *pos = list;
+    while (*pos != '\0') {
+      size_t length = strcspn(pos, ",");
+      if (length == 0 || length >= sizeof(name)) {
+        return false;
+      }
+      memcpy(name, pos, length);
+      name[length] = '\0';
+      T value;
+      if (!parse(name, value)) {
+        return false;
+      }
+      values.push_back(value);
+      pos += length;
+      if (*pos == ',') {
+        ++pos;
+      }
+    }
+    return !values.empty();
+  }
+
+  /**
+   * Prints every run in a results file as CSV, or returns false if it isn't
+   * a valid results file.
+   */
+  bool print_csv(const char *path) {
+    sim::SweepFile file;
+    if (!file.open(path)) {
+      return false;
+    }
+    for (int i = 0; i < sim::COLUMN_COUNT; ++i) {
+      printf("%s%s", i ? "," : "", sim::string(sim::SweepColumn(i)));
+    }
+    printf("\n");
+    for (size_t run = 0; run < file.size(); ++run) {
+      for (int i = 0; i < sim::COLUMN_COUNT; ++i) {
+        sim::SweepColumn column = sim::SweepColumn(i);
+        if (i != 0) {
+          printf(",");
+        }
+        switch (column) {
+          case sim::COLUMN_PATTERN:
+            printf("%s", sim::string(sim::Pattern(
+                    file.column<uint8_t>(column)[run])));
+            break;
+          case sim::COLUMN_DISPATCH:
+            printf("%s", sim::string(sim::Dispatch(
+                    file.column<uint8_t>(column)[run])));
+            break;
+          case sim::COLUMN_RATE:
+          case sim::COLUMN_WAIT_MEAN:
+          case sim::COLUMN_TRAVEL_MEAN:
+            printf("%g", file.column<double>(column)[run]);
+            break;
+          default:
+            switch (sim::SweepFile::width(column)) {
+              case 1:
+                printf("%u", file.column<uint8_t>(column)[run]);
+                break;
+              case 4:
+                printf("%u", file.column<uint32_t>(column)[run]);
+                break;
+              default:
+                printf("%llu",
+                    (unsigned long long)file.column<uint64_t>(column)[run]);
+                break;
+            }
+            break;
+        }
+      }
+      printf("\n");
+    }
+    return true;
+  }
+}
+
+/**
+ * Runs every combination of a grid of building sizes, traffic and dispatch
+ * policies across all cores, writing the results to a columnar file which
+ * can be resumed if the sweep is interrupted.
+ */
+int main(int argc, char *argv[]) {
+  const char *output_path = NULL;
+  bool resume = false;
+  sim::SweepGrid grid;
+  size_t thread_count = 0;
+  std::vector<double> numbers;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "ho:Rf:e:w:l:d:n:s:r:t:k:j:i:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      case 'R':
+        resume = true;
+        break;
+      case 'f':
+      case 'e':
+        if (!parse_numbers(optarg, numbers)) {
+          fprintf(stderr, "Invalid list: %s\n", optarg);
+          exit(1);
+        }
+        for (double value : numbers) {
+          if (opt == 'f') {
+            grid.floors.push_back(sim::floor_t(value));
+          } else {
+            grid.elevators.push_back(size_t(value));
+          }
+        }
+        break;
+      case 'l':
+        if (!parse_numbers(optarg, grid.rates)) {
+          fprintf(stderr, "Invalid list: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'w':
+        if (!parse_names(optarg, &sim::parse_pattern, grid.patterns)) {
+          fprintf(stderr, "Invalid patterns: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'd':
+        if (!parse_names(optarg, &sim::parse_dispatch, grid.dispatches)) {
+          fprintf(stderr, "Invalid dispatches: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'n':
+        grid.seeds = atoi(optarg);
+        break;
+      case 's':
+        grid.base.seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'r':
+        grid.base.requests = atoi(optarg);
+        break;
+      case 't':
+        grid.base.max_ticks = atoi(optarg);
+        break;
+      case 'k':
+        grid.base.passengers = true;
+        grid.base.capacity = atoi(optarg);
+        break;
+      case 'j':
+        thread_count = atoi(optarg);
+        break;
+      case 'i':
+        if (!print_csv(optarg)) {
+          fprintf(stderr, "Unable to read results file %s\n", optarg);
+          return 1;
+        }
+        return 0;
+    }
+  }
+  if (output_path == NULL) {
+    syntax(argv[0]);
+    exit(1);
+  }
+
+  sim::SweepFile file;
+  if (resume) {
+    if (!file.resume(output_path, grid)) {
+      fprintf(stderr, "Unable to resume %s: missing, or not for this grid\n",
+          output_path);
+      return 1;
+    }
+  } else if (!file.create(output_path, grid)) {
+    fprintf(stderr, "Unable to create results file %s\n", output_path);
+    return 1;
+  }
+  size_t total = file.size(), already_done = file.done_count();
+  printf("Sweeping %lu runs, %lu already done\n", total, already_done);
+
+  sim::verbose_enabled = false;
+  auto start = std::chrono::steady_clock::now();
+  sim::SweepRunner runner(thread_count);
+  bool ok = runner.run(grid, file, [](size_t done, size_t total) {
+        fprintf(stderr, "\r%lu/%lu runs done", done, total);
+      });
+  fprintf(stderr, "\n");
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (!file.close() || !ok) {
+    fprintf(stderr, "Unable to write results file %s\n", output_path);
+    return 1;
+  }
+  printf("Ran %lu runs in %.2fs\n", total - already_done, seconds);
+  return 0;
+}
@@ -0,0 +1,160 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "sim/logging.h"
+#include "sim/workload.h"
+
+namespace {
+  void syntax(char* appname) {
+    printf("%s [-h] [-f floors] [-e elevators] [-t maxticks] [-o packedfile] "
+        "[-i] [-d dispatch] workload\n", appname);
+    printf("  Workloads are CSV 'tick,source,dest' lines or packed binary.\n"
+        "  -o: Convert the workload to packed binary instead of running it\n"
+        "  -i: Only insert the requests, without running the simulation,\n"
+        "      to measure ingestion throughput\n"
+        "  -d: Pickup dispatch: fewest, eta, batch or rollout\n");
+  }
+
+  double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+  int convert(sim::RequestSource &source, const char *out_path) {
+    sim::BinaryRequestWriter writer;
+    if (!writer.open(out_path)) {
+      fprintf(stderr, "Unable to create %s\n", out_path);
+      return 1;
+    }
+    std::vector<sim::Request> batch(4096);
+    size_t total = 0;
+    for (size_t count; (count = source.read(batch.data(), batch.size())) > 0;) {
+      for (size_t i = 0; i < count; ++i) {
+        writer.write(batch[i]);
+      }
+      total += count;
+    }
+    if (!writer.close()) {
+      fprintf(stderr, "Unable to write %s\n", out_path);
+      return 1;
+    }
+    printf("Wrote %lu requests to %s\n", total, out_path);
+    return 0;
+  }
+
+  void print_latency(const char *name, const sim::Histogram &histogram) {
+    printf("%s ticks: p50 %lu, p99 %lu, p999 %lu, max %lu (%lu requests)\n",
+        name, histogram.percentile(50), histogram.percentile(99),
+        histogram.percentile(99.9), histogram.max(), histogram.count());
+  }
+}
+
+/**
+ * Runs a recorded workload through a scheduler as fast as possible, or
+ * converts it to the packed binary format.
+ */
+int main(int argc, char *argv[]) {
+  sim::floor_t floor_count = 50;
+  size_t elevator_count = 16;
+  size_t total_tick_max = size_t(-1);
+  const char *out_path = NULL;
+  bool ingest_only = false;
+  sim::Dispatch dispatch = sim::FEWEST_REQUESTS;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "hf:e:t:o:id:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'f':
+        floor_count = atoi(optarg);
+        break;
+      case 'e':
+        elevator_count = atoi(optarg);
+        break;
+      case 't':
+        total_tick_max = strtoull(optarg, NULL, 10);
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      case 'i':
+        ingest_only = true;
+        break;
+      case 'd':
+        if (!sim::parse_dispatch(optarg, dispatch)) {
+          fprintf(stderr, "Unknown dispatch: %s\n", optarg);
+          exit(1);
+        }
+        break;
+    }
+  }
+  if (optind + 1 != argc) {
+    syntax(argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<sim::RequestSource> source =
+    sim::open_request_source(argv[optind]);
+  if (!source) {
+    fprintf(stderr, "Unable to open workload %s\n", argv[optind]);
+    return 1;
+  }
+  if (out_path != NULL) {
+    return convert(*source, out_path);
+  }
+
+  sim::verbose_enabled = false;
+  sim::Scheduler scheduler(floor_count, elevator_count);
+  scheduler.set_dispatch(dispatch);
+  sim::RequestFeeder feeder(*source);
+  size_t read = 0, inserted = 0;
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  if (ingest_only) {
+    std::vector<sim::Request> batch(4096);
+    for (size_t count; (count = source->read(batch.data(), batch.size())) > 0;) {
+      for (size_t i = 0; i < count; ++i) {
+        if (scheduler.insert_request(batch[i].source, batch[i].dest)) {
+          ++inserted;
+        }
+      }
+      read += count;
+    }
+    double elapsed = seconds_since(start);
+    printf("Read %lu requests (%lu new) in %.3fs: %.2fM requests/s\n",
+        read, inserted, elapsed, read / elapsed / 1e6);
+    return 0;
+  }
+
+  // Skip over any quiet stretches between requests.
+  while (!feeder.done() && scheduler.tick_count() < total_tick_max) {
+    size_t next_tick = feeder.next_tick();
+    if (next_tick > scheduler.tick_count() + 1) {
+      scheduler.run_until(std::min(next_tick - 1, total_tick_max));
+      continue;
+    }
+    inserted += feeder.insert_due(scheduler);
+    scheduler.tick();
+  }
+  while (!scheduler.idle() && scheduler.tick_count() < total_tick_max) {
+    if (scheduler.advance_to_next_event() == 0) {
+      break;
+    }
+  }
+
+  double elapsed = seconds_since(start);
+  printf("%s after %lu ticks: %lu requests inserted in %.3fs (%.2fM ticks/s)\n",
+      scheduler.idle() ? "Completed" : "Still busy", scheduler.tick_count(),
+      inserted, elapsed, scheduler.tick_count() / elapsed / 1e6);
+  print_latency("Wait", scheduler.latency().wait);
+  print_latency("Travel", scheduler.latency().travel);
+  return scheduler.idle() ? 0 : 2;
+}
@@ -0,0 +1,418 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "sim/logging.h"
+#include "sim/random.h"
+#include "sim/scheduler.h"
+#include "sim/traffic.h"
+
+namespace {
+  typedef std::chrono::steady_clock bench_clock;
+
+  /**
+   * One point in the sweep.
+   */
+  class Config {
+   public:
+    sim::Pattern pattern;
+    sim::floor_t floors;
+    size_t elevators;
+
+    // Average requests arriving per tick.
+    double load;
+
+    sim::Dispatch dispatch;
+  };
+
+  /**
+   * Average cost of each measured operation for one Config, in nanoseconds.
+   */
+  class Result {
+   public:
+    Result()
+      : ticks(0), scheduler_tick(0), elevator_tick(0), approve_request(0),
+        idle(0), pending_dests(0), elevator_requests(0), wait_mean(0),
+        wait_p99(0) { }
+
+    // Scheduler ticks which were measured, which may be fewer than requested
+    // if the time budget ran out.
+    size_t ticks;
+
+    double scheduler_tick, elevator_tick, approve_request, idle;
+
+    // How busy the scheduler was at the end of the measured ticks.
+    size_t pending_dests, elevator_requests;
+
+    // Wait times of the requests picked up so far, in ticks, to compare the
+    // service given by each dispatch.
+    double wait_mean;
+    uint64_t wait_p99;
+  };
+
+  /**
+   * A scheduler which lets the benchmark copy out its elevators, so that
+   * they may be measured in a realistic state.
+   */
+  class BenchScheduler : public sim::Scheduler {
+   public:
+    BenchScheduler(sim::floor_t floors, size_t elevators)
+      : sim::Scheduler(floors, elevators) { }
+
+    const std::vector<sim::Elevator> &peek_elevators() const {
+      return elevators;
+    }
+  };
+
+  double ns_since(bench_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(
+        bench_clock::now() - start).count();
+  }
+
+  /**
+   * Measures each operation for the provided config. The scheduler is warmed
+   * up first so that elevators and pickup groups are in a steady state, then
+   * Scheduler::tick() is timed across up to 'ticks' ticks of arriving
+   * requests, stopping early once 'budget' seconds have been spent. The
+   * Elevator and idle() measurements are taken from the resulting state.
+   */
+  Result measure(const Config &config, size_t warmup, size_t ticks,
+      double budget, uint64_t seed) {
+    BenchScheduler scheduler(config.floors, config.elevators);
+    scheduler.set_dispatch(config.dispatch);
+    sim::TrafficGenerator traffic(config.floors, config.pattern, config.load,
+        seed);
+
+    // Pre-generate the arrivals, so that the timed loop only covers the
+    // scheduler itself.
+    std::vector<sim::Request> requests;
+    std::vector<size_t> tick_ends;
+    tick_ends.reserve(warmup + ticks);
+    for (size_t i = 0; i < warmup + ticks; ++i) {
+      traffic.generate(i + 1, requests);
+      tick_ends.push_back(requests.size());
+    }
+
+    // The clock is only checked every few ticks, to keep it out of the
+    // measurement for small buildings.
+    const size_t CHECK_INTERVAL = 16;
+    double budget_ns = budget * 1e9;
+
+    size_t next = 0;
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < warmup; ++i) {
+      for (; next < tick_ends[i]; ++next) {
+        scheduler.insert_request(requests[next].source, requests[next].dest);
+      }
+      scheduler.tick();
+      if (i % CHECK_INTERVAL == 0 && ns_since(start) > budget_ns / 4) {
+        next = tick_ends[warmup - 1];
+        break;
+      }
+    }
+
+    Result result;
+    start = bench_clock::now();
+    while (result.ticks < ticks) {
+      size_t i = warmup + result.ticks;
+      for (; next < tick_ends[i]; ++next) {
+        scheduler.insert_request(requests[next].source, requests[next].dest);
+      }
+      scheduler.tick();
+      ++result.ticks;
+      if (result.ticks % CHECK_INTERVAL == 0 && ns_since(start) > budget_ns) {
+        break;
+      }
+    }
+    result.scheduler_tick = ns_since(start) / result.ticks;
+    result.pending_dests = scheduler.stats().pending_dests;
+    result.elevator_requests = scheduler.stats().elevator_requests;
+    result.wait_mean = scheduler.latency().wait.mean();
+    result.wait_p99 = scheduler.latency().wait.percentile(99);
+
+    const size_t CALLS = 1 << 16;
+
+    // Check random pickups against every elevator, like the scheduler does.
+    std::vector<sim::Elevator> elevators = scheduler.peek_elevators();
+    sim::Random random(seed + 1);
+    std::vector<sim::floor_t> floors;
+    std::vector<sim::Direction> directions;
+    size_t rounds = CALLS / elevators.size() + 1;
+    for (size_t i = 0; i < rounds; ++i) {
+      floors.push_back(random.below(config.floors));
+      directions.push_back(random.below(2) ? sim::UP : sim::DOWN);
+    }
+    size_t approved = 0;
+    start = bench_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+      for (sim::Elevator &elevator : elevators) {
+        approved += elevator.approve_request(floors[i], directions[i]);
+      }
+    }
+    result.approve_request = ns_since(start) / (rounds * elevators.size());
+
+    // Tick copies of the elevators a few times each, refreshing the copies
+    // so that they don't all run out of requests and sit idle.
+    const size_t ROUNDS_PER_COPY = 16;
+    double tick_ns = 0;
+    size_t tick_calls = 0;
+    while (tick_calls < CALLS) {
+      elevators = scheduler.peek_elevators();
+      start = bench_clock::now();
+      for (size_t i = 0; i < ROUNDS_PER_COPY; ++i) {
+        for (sim::Elevator &elevator : elevators) {
+          approved += elevator.tick() != sim::IDLE;
+        }
+      }
+      tick_ns += ns_since(start);
+      tick_calls += ROUNDS_PER_COPY * elevators.size();
+    }
+    result.elevator_tick = tick_ns / tick_calls;
+
+    // 'volatile' keeps the compiler from dropping the calls.
+    volatile bool idle = false;
+    start = bench_clock::now();
+    for (size_t i = 0; i < CALLS; ++i) {
+      idle = scheduler.idle();
+    }
+    result.idle = ns_since(start) / CALLS;
+    (void)idle;
+
+    // Also keep the approve/tick results alive.
+    if (approved == size_t(-1)) {
+      printf("\n");
+    }
+    return result;
+  }
+
+  template <typename T>
+  bool parse_list(const char *arg, std::vector<T> &values) {
+    values.clear();
+    std::string copy(arg);
+    char *save = NULL;
+    for (char *token = strtok_r(&copy[0], ",", &save); token != NULL;
+        token = strtok_r(NULL, ",", &save)) {
+      char *end = NULL;
+      double value = strtod(token, &end);
+      if (end == token || *end != '\0' || value <= 0) {
+        return false;
+      }
+      values.push_back(T(value));
+    }
+    return !values.empty();
+  }
+
+  void print_csv_header(FILE *out) {
+    fprintf(out, "workload,dispatch,floors,elevators,load,ticks,scheduler_tick_ns,"
+        "elevator_tick_ns,approve_request_ns,idle_ns,pending_dests,"
+        "elevator_requests,wait_mean,wait_p99\n");
+  }
+
+  void print_csv(FILE *out, const Config &config, const Result &result) {
+    fprintf(out, "%s,%s,%lu,%lu,%g,%lu,%.1f,%.2f,%.2f,%.2f,%lu,%lu,%.1f,%lu\n",
+        sim::string(config.pattern), sim::string(config.dispatch),
+        config.floors, config.elevators,
+        config.load, result.ticks, result.scheduler_tick, result.elevator_tick,
+        result.approve_request, result.idle, result.pending_dests,
+        result.elevator_requests, result.wait_mean, result.wait_p99);
+  }
+
+  void print_json(FILE *out, const Config &config, const Result &result,
+      bool first) {
+    fprintf(out, "%s\n  {\"workload\": \"%s\", \"dispatch\": \"%s\", "
+        "\"floors\": %lu, "
+        "\"elevators\": %lu, \"load\": %g, \"ticks\": %lu, "
+        "\"scheduler_tick_ns\": %.1f, "
+        "\"elevator_tick_ns\": %.2f, \"approve_request_ns\": %.2f, "
+        "\"idle_ns\": %.2f, \"pending_dests\": %lu, "
+        "\"elevator_requests\": %lu, \"wait_mean\": %.1f, \"wait_p99\": %lu}",
+        first ? "" : ",", sim::string(config.pattern),
+        sim::string(config.dispatch), config.floors,
+        config.elevators, config.load, result.ticks, result.scheduler_tick,
+        result.elevator_tick, result.approve_request, result.idle,
+        result.pending_dests, result.elevator_requests, result.wait_mean,
+        result.wait_p99);
+  }
+
+  void syntax(char* appname) {
+    printf("%s [-h] [-f floors,...] [-e elevators,...] [-l loads,...] "
+        "[-w patterns,...] [-d dispatches,...] [-t ticks] [-u warmup] [-m seconds] [-s seed] "
+        "[-j] [-o outfile]\n", appname);
+    printf("  Runs every combination of the provided lists, printing the\n"
+        "  average ns per call of Scheduler::tick(), Elevator::tick(),\n"
+        "  Elevator::approve_request() and Scheduler::idle().\n"
+        "  -l: Average requests arriving per tick, may be fractional\n"
+        "  -w: Any of inter-floor, up-peak, down-peak, lunch\n"
+        "  -d: Any of fewest, eta, batch, rollout\n"
+        "  -t: Ticks to measure per combination\n"
+        "  -u: Ticks to run before measuring\n"
+        "  -m: Stop measuring a combination's ticks after this many seconds\n"
+        "  -j: Print JSON instead of CSV\n"
+        "  -o: Write results to a file instead of stdout\n");
+  }
+}
+
+/**
+ * Microbenchmarks for the Scheduler and Elevator hot paths, swept across
+ * building sizes, loads and traffic patterns.
+ */
+int main(int argc, char *argv[]) {
+  std::vector<sim::floor_t> floor_counts = {10, 100, 1000, 10000};
+  std::vector<size_t> elevator_counts = {1, 16, 256, 4096};
+  std::vector<double> loads = {0.1, 1, 10};
+  std::vector<sim::Pattern> patterns = {
+    sim::INTER_FLOOR, sim::UP_PEAK, sim::DOWN_PEAK};
+  std::vector<sim::Dispatch> dispatches = {sim::FEWEST_REQUESTS};
+  size_t ticks = 1000;
+  size_t warmup = 200;
+  double budget = 1;
+  uint64_t seed = 0;
+  bool json = false;
+  const char *out_path = NULL;
+
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "hf:e:l:w:d:t:u:m:s:jo:")) != -1) {
+    switch (opt) {
+      case 'h':
+        syntax(argv[0]);
+        exit(1);
+        break;
+      case 'f':
+        if (!parse_list(optarg, floor_counts)) {
+          fprintf(stderr, "Invalid floor list: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'e':
+        if (!parse_list(optarg, elevator_counts)) {
+          fprintf(stderr, "Invalid elevator list: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'l':
+        if (!parse_list(optarg, loads)) {
+          fprintf(stderr, "Invalid load list: %s\n", optarg);
+          exit(1);
+        }
+        break;
+      case 'w':
+        {
+          patterns.clear();
+          std::string copy(optarg);
+          char *save = NULL;
+          for (char *token = strtok_r(&copy[0], ",", &save); token != NULL;
+              token = strtok_r(NULL, ",", &save)) {
+            sim::Pattern pattern;
+            if (!sim::parse_pattern(token, pattern)) {
+              fprintf(stderr, "Unknown pattern: %s\n", token);
+              exit(1);
+            }
+            patterns.push_back(pattern);
+          }
+        }
+        break;
+      case 'd':
+        {
+          dispatches.clear();
+          std::string copy(optarg);
+          char *save = NULL;
+          for (char *token = strtok_r(&copy[0], ",", &save); token != NULL;
+              token = strtok_r(NULL, ",", &save)) {
+            sim::Dispatch dispatch;
+            if (!sim::parse_dispatch(token, dispatch)) {
+              fprintf(stderr, "Unknown dispatch: %s\n", token);
+              exit(1);
+            }
+            dispatches.push_back(dispatch);
+          }
+        }
+        break;
+      case 't':
+        ticks = atoi(optarg);
+        break;
+      case 'u':
+        warmup = atoi(optarg);
+        break;
+      case 'm':
+        budget = atof(optarg);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'j':
+        json = true;
+        break;
+      case 'o':
+        out_path = optarg;
+        break;
+      default:
+        syntax(argv[0]);
+        exit(1);
+    }
+  }
+  if (ticks == 0) {
+    fprintf(stderr, "Need at least one tick to measure\n");
+    exit(1);
+  }
+
+  FILE *out = stdout;
+  if (out_path != NULL) {
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "Unable to create %s\n", out_path);
+      exit(1);
+    }
+  }
+
+  sim::verbose_enabled = false;
+  if (json) {
+    fprintf(out, "[");
+  } else {
+    print_csv_header(out);
+  }
+  std::vector<Config> configs;
+  for (sim::Pattern pattern : patterns) {
+    for (sim::Dispatch dispatch : dispatches) {
+      for (sim::floor_t floors : floor_counts) {
+        if (floors < 2) {
+          // No valid requests in a single-floor building.
+          continue;
+        }
+        for (size_t elevators : elevator_counts) {
+          for (double load : loads) {
+            Config config;
+            config.pattern = pattern;
+            config.floors = floors;
+            config.elevators = elevators;
+            config.load = load;
+            config.dispatch = dispatch;
+            configs.push_back(config);
+          }
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < configs.size(); ++i) {
+    Result result = measure(configs[i], warmup, ticks, budget, seed);
+    if (json) {
+      print_json(out, configs[i], result, i == 0);
+    } else {
+      print_csv(out, configs[i], result);
+    }
+    fflush(out);
+  }
+  if (json) {
+    fprintf(out, "\n]\n");
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
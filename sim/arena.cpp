@@ -0,0 +1,78 @@
+#include "sim/arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+sim::Arena::Arena(size_t block_size/*=64*1024*/)
+  : block_size_(block_size),
+    current_(0),
+    offset_(0),
+    used_before_(0) { }
+
+sim::Arena::~Arena() {
+  for (Block &block : blocks_) {
+    ::operator delete(block.data);
+  }
+}
+
+void *sim::Arena::allocate(size_t bytes, size_t align/*=max_align_t*/) {
+  assert((align & (align - 1)) == 0);
+  while (current_ < blocks_.size()) {
+    Block &block = blocks_[current_];
+    uintptr_t start = reinterpret_cast<uintptr_t>(block.data) + offset_;
+    size_t padding = (align - start % align) % align;
+    if (offset_ + padding + bytes <= block.size) {
+      offset_ += padding + bytes;
+      return block.data + offset_ - bytes;
+    }
+    // Doesn't fit, so move on to the next block, wasting the rest of this
+    // one until the next reset().
+    block.used = offset_;
+    used_before_ += offset_;
+    offset_ = 0;
+    ++current_;
+  }
+
+  // Out of blocks. Make a new one which is big enough for this allocation.
+  Block block;
+  block.size = std::max(block_size_, bytes + align);
+  block.used = 0;
+  block.data = static_cast<char*>(::operator new(block.size));
+  blocks_.push_back(block);
+  return allocate(bytes, align);
+}
+
+void sim::Arena::reset() {
+  current_ = 0;
+  offset_ = 0;
+  used_before_ = 0;
+}
+
+size_t sim::Arena::used() const {
+  return used_before_ + offset_;
+}
+
+void sim::Arena::save(std::vector<char> &out) const {
+  out.resize(used());
+  char *pos = out.data();
+  for (size_t i = 0; i < blocks_.size() && i <= current_; ++i) {
+    size_t used = (i == current_) ? offset_ : blocks_[i].used;
+    std::copy(blocks_[i].data, blocks_[i].data + used, pos);
+    pos += used;
+  }
+}
+
+bool sim::Arena::restore(const std::vector<char> &in) {
+  if (in.size() != used()) {
+    return false;
+  }
+  const char *pos = in.data();
+  for (size_t i = 0; i < blocks_.size() && i <= current_; ++i) {
+    size_t used = (i == current_) ? offset_ : blocks_[i].used;
+    std::copy(pos, pos + used, blocks_[i].data);
+    pos += used;
+  }
+  return true;
+}
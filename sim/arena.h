@@ -0,0 +1,95 @@
+#ifndef _sim_arena_h_
+#define _sim_arena_h_
+
+#include <cstddef>
+#include <vector>
+
+namespace sim {
+
+  /**
+   * A monotonic memory arena. Allocations are carved off the end of a large
+   * block by bumping an offset, and are never freed individually. Instead,
+   * reset() rewinds the whole arena in constant time, keeping its blocks for
+   * reuse.
+   *
+   * A Scheduler sizes its arena's first block to fit all of its per-floor
+   * and per-elevator state, so a whole simulation lives in one contiguous
+   * block and building or resetting it doesn't touch the heap. Further blocks
+   * are only added if the first one runs out.
+   */
+  class Arena {
+   public:
+    /**
+     * Creates an empty arena. The first block is allocated on first use, and
+     * holds at least 'block_size' bytes.
+     */
+    explicit Arena(size_t block_size = 64 * 1024);
+    virtual ~Arena();
+
+    /**
+     * Returns 'bytes' of memory aligned to 'align', which must be a power of
+     * two. The memory is valid until reset() or the arena is destroyed.
+     */
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    /**
+     * Allocates an array of 'count' values of type T. The values aren't
+     * initialized.
+     */
+    template <typename T>
+    T *allocate_array(size_t count) {
+      return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Forgets all allocations, so that the memory may be handed out again.
+     */
+    void reset();
+
+    /**
+     * Returns the number of bytes handed out since the last reset(),
+     * including any alignment padding.
+     */
+    size_t used() const;
+
+    /**
+     * Copies the contents of everything allocated since the last reset() to
+     * 'out', replacing what it held. This is a memcpy per block used, which
+     * is normally just the one.
+     */
+    void save(std::vector<char> &out) const;
+
+    /**
+     * Overwrites the allocations with contents from save(). This is only
+     * meaningful if the same sequence of allocations has been made in this
+     * arena as in the one which was saved, eg by a Scheduler with the same
+     * dimensions. Returns false, without changing anything, if the sizes
+     * don't match.
+     */
+    bool restore(const std::vector<char> &in);
+
+   private:
+    Arena(const Arena&);
+    Arena &operator=(const Arena&);
+
+    class Block {
+     public:
+      char *data;
+      size_t size;
+
+      // Bytes handed out of this block, once it's been moved past.
+      size_t used;
+    };
+
+    size_t block_size_;
+    std::vector<Block> blocks_;
+
+    // The block being allocated from, and the offset of its free space.
+    size_t current_, offset_;
+
+    // Bytes used in the blocks before 'current_'.
+    size_t used_before_;
+  };
+}
+
+#endif /* _sim_arena_h_ */
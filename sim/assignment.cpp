@@ -0,0 +1,84 @@
+#include "sim/assignment.h"
+
+#include <cassert>
+#include <limits>
+
+namespace {
+  // Larger than any sum of allowed costs, so that it can't be mistaken for
+  // a real slack value.
+  const int64_t INFINITE = std::numeric_limits<int64_t>::max() / 2;
+
+  // Marks a column which doesn't have a row yet.
+  const size_t NO_ROW = size_t(-1);
+}
+
+bool sim::AssignmentSolver::solve(const int64_t *costs, size_t rows,
+    size_t cols, clock::time_point deadline, std::vector<size_t> &assignment) {
+  assert(rows <= cols);
+  /* Column 'cols' is a virtual starting column, which holds the row being
+   * added while we search for an augmenting path to a free column. */
+  row_potential_.assign(rows, 0);
+  col_potential_.assign(cols + 1, 0);
+  col_row_.assign(cols + 1, NO_ROW);
+  previous_col_.resize(cols + 1);
+  const size_t START = cols;
+
+  for (size_t row = 0; row < rows; ++row) {
+    if (clock::now() >= deadline) {
+      return false;
+    }
+    col_row_[START] = row;
+    size_t col = START;
+    min_slack_.assign(cols + 1, INFINITE);
+    visited_.assign(cols + 1, false);
+
+    // Grow a tree of tight edges until it reaches a free column.
+    do {
+      visited_[col] = true;
+      size_t tree_row = col_row_[col];
+      int64_t delta = INFINITE;
+      size_t next_col = START;
+      const int64_t *row_costs = costs + tree_row * cols;
+      for (size_t j = 0; j < cols; ++j) {
+        if (visited_[j]) {
+          continue;
+        }
+        int64_t slack = row_costs[j] - row_potential_[tree_row]
+          - col_potential_[j];
+        if (slack < min_slack_[j]) {
+          min_slack_[j] = slack;
+          previous_col_[j] = col;
+        }
+        if (min_slack_[j] < delta) {
+          delta = min_slack_[j];
+          next_col = j;
+        }
+      }
+      // Adjust the potentials so that at least one more edge is tight.
+      for (size_t j = 0; j <= cols; ++j) {
+        if (visited_[j]) {
+          row_potential_[col_row_[j]] += delta;
+          col_potential_[j] -= delta;
+        } else {
+          min_slack_[j] -= delta;
+        }
+      }
+      col = next_col;
+    } while (col_row_[col] != NO_ROW);
+
+    // Flip the assignments along the path back to the starting column.
+    while (col != START) {
+      size_t previous = previous_col_[col];
+      col_row_[col] = col_row_[previous];
+      col = previous;
+    }
+  }
+
+  assignment.assign(rows, 0);
+  for (size_t j = 0; j < cols; ++j) {
+    if (col_row_[j] != NO_ROW) {
+      assignment[col_row_[j]] = j;
+    }
+  }
+  return true;
+}
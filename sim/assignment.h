@@ -0,0 +1,48 @@
+#ifndef _sim_assignment_h_
+#define _sim_assignment_h_
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+namespace sim {
+
+  /**
+   * Solves the assignment problem: given a matrix of costs for assigning each
+   * row to each column, finds the one-to-one assignment of every row to a
+   * distinct column with the lowest total cost. This uses the Hungarian
+   * algorithm with row and column potentials, which is O(rows^2 * cols).
+   *
+   * Costs must be non-negative. Pairs which mustn't be assigned may be given
+   * a cost larger than the total of any assignment of allowed pairs, so that
+   * they're only used when there's no other way to assign every row. Callers
+   * should check the cost of each returned pair for that case.
+   *
+   * The solver keeps its working arrays between calls, so that solving a
+   * similar sized problem every tick doesn't allocate.
+   */
+  class AssignmentSolver {
+   public:
+    typedef std::chrono::steady_clock clock;
+
+    AssignmentSolver() { }
+    virtual ~AssignmentSolver() { }
+
+    /**
+     * Assigns each of the 'rows' rows to one of the 'cols' columns, where
+     * 'costs' holds the row-major cost matrix and rows <= cols. On success,
+     * 'assignment' holds the column for each row and true is returned. The
+     * rows are added one at a time, and if the provided deadline passes
+     * before they've all been added, false is returned instead.
+     */
+    bool solve(const int64_t *costs, size_t rows, size_t cols,
+        clock::time_point deadline, std::vector<size_t> &assignment);
+
+   private:
+    std::vector<int64_t> row_potential_, col_potential_, min_slack_;
+    std::vector<size_t> col_row_, previous_col_;
+    std::vector<bool> visited_;
+  };
+}
+
+#endif /* _sim_assignment_h_ */
@@ -0,0 +1,118 @@
+#include "sim/batch.h"
+
+sim::RunResult sim::run_scenario(Scheduler &scheduler,
+    const Scenario &scenario, LatencyStats *latency/*=NULL*/) {
+  RunResult result;
+  scheduler.set_dispatch(scenario.dispatch);
+  scheduler.set_passengers(scenario.passengers, scenario.capacity);
+
+  size_t ticks_elapsed = 0;
+  // No valid requests in a single-floor building.
+  if (scenario.floors >= 2 && scenario.requests > 0) {
+    // Input random requests as their ticks come up.
+    TrafficGenerator traffic(scenario.floors, scenario.pattern,
+        scenario.rate, scenario.seed, scenario.requests);
+    RequestFeeder feeder(traffic);
+    for (; !feeder.done() && ticks_elapsed < scenario.max_ticks;
+         ++ticks_elapsed) {
+      result.inserted += feeder.insert_due(scheduler);
+      scheduler.tick();
+    }
+  }
+  for (; ticks_elapsed < scenario.max_ticks; ++ticks_elapsed) {
+    if (scheduler.idle()) {
+      break;
+    }
+    scheduler.tick();
+  }
+
+  result.ticks = ticks_elapsed;
+  result.completed = scheduler.idle();
+  result.stats = scheduler.stats();
+  result.phases = scheduler.phase_timings();
+  if (latency != NULL) {
+    latency->wait.merge(scheduler.latency().wait);
+    latency->travel.merge(scheduler.latency().travel);
+  }
+  return result;
+}
+
+sim::RunResult sim::run_scenario(const Scenario &scenario,
+    LatencyStats *latency/*=NULL*/) {
+  Scheduler scheduler(scenario.floors, scenario.elevators);
+  return run_scenario(scheduler, scenario, latency);
+}
+
+sim::SchedulerCache::SchedulerCache(size_t slots)
+  : schedulers_(slots),
+    floors_(slots, 0),
+    elevators_(slots, 0),
+    created_(slots, 0) { }
+
+sim::Scheduler &sim::SchedulerCache::get(size_t slot,
+    const Scenario &scenario) {
+  std::unique_ptr<Scheduler> &scheduler = schedulers_[slot];
+  if (scheduler && floors_[slot] == scenario.floors
+      && elevators_[slot] == scenario.elevators) {
+    scheduler->reset();
+  } else {
+    scheduler.reset(new Scheduler(scenario.floors, scenario.elevators));
+    floors_[slot] = scenario.floors;
+    elevators_[slot] = scenario.elevators;
+    ++created_[slot];
+  }
+  return *scheduler;
+}
+
+size_t sim::SchedulerCache::created() const {
+  size_t total = 0;
+  for (size_t count : created_) {
+    total += count;
+  }
+  return total;
+}
+
+sim::BatchRunner::BatchRunner(size_t threads/*=0*/)
+  : pool_(threads),
+    schedulers_(pool_.size()) { }
+
+sim::BatchResult sim::BatchRunner::run(const std::vector<Scenario> &scenarios) {
+  BatchResult result;
+  result.runs.resize(scenarios.size());
+  // Each run writes to its own result slot, so no locking is needed there.
+  // Latencies are collected per thread, then merged into the total once
+  // every run is done.
+  std::vector<LatencyStats> latencies(pool_.size());
+  pool_.parallel_for_slots(scenarios.size(),
+      [this, &scenarios, &result, &latencies](size_t slot, size_t begin,
+          size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          result.runs[i] = run_scenario(schedulers_.get(slot, scenarios[i]),
+              scenarios[i], &latencies[slot]);
+        }
+      });
+  for (const LatencyStats &latency : latencies) {
+    result.latency.wait.merge(latency.wait);
+    result.latency.travel.merge(latency.travel);
+  }
+
+  size_t total_ticks = 0;
+  for (const RunResult &run : result.runs) {
+    result.phases.merge(run.phases);
+    if (!run.completed) {
+      continue;
+    }
+    if (result.completed == 0 || run.ticks < result.min_ticks) {
+      result.min_ticks = run.ticks;
+    }
+    if (result.completed == 0 || run.ticks > result.max_ticks) {
+      result.max_ticks = run.ticks;
+    }
+    total_ticks += run.ticks;
+    ++result.completed;
+  }
+  if (result.completed > 0) {
+    result.mean_ticks = double(total_ticks) / result.completed;
+  }
+  return result;
+}
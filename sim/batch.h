@@ -0,0 +1,180 @@
+#ifndef _sim_batch_h_
+#define _sim_batch_h_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "sim/scheduler.h"
+#include "sim/traffic.h"
+
+namespace sim {
+
+  /**
+   * The configuration for one simulation run: the building, and the random
+   * requests to be fed into it.
+   */
+  class Scenario {
+   public:
+    Scenario()
+      : floors(50), elevators(16), requests(1000), max_ticks(10000), seed(0),
+        pattern(INTER_FLOOR), rate(1), dispatch(FEWEST_REQUESTS),
+        passengers(false), capacity(0) { }
+
+    floor_t floors;
+    size_t elevators;
+
+    // Random requests to insert, from a TrafficGenerator.
+    size_t requests;
+
+    // Give up if the scheduler is still busy after this many ticks.
+    size_t max_ticks;
+
+    // Seed for the run's random requests.
+    uint64_t seed;
+
+    // The traffic pattern of the requests, and their average arrivals per
+    // tick.
+    Pattern pattern;
+    double rate;
+
+    // How the run's scheduler assigns pickups.
+    Dispatch dispatch;
+
+    // Whether every request is a separate passenger, and how many each
+    // elevator may carry if so (see Scheduler::set_passengers()).
+    bool passengers;
+    size_t capacity;
+  };
+
+  /**
+   * The outcome of running a Scenario.
+   */
+  class RunResult {
+   public:
+    RunResult() : ticks(0), completed(false), inserted(0) { }
+
+    // Ticks until the scheduler went idle, or max_ticks if it didn't.
+    size_t ticks;
+
+    // Whether the scheduler went idle within max_ticks.
+    bool completed;
+
+    // Requests which were accepted by insert_request().
+    size_t inserted;
+
+    // The scheduler's counters at the end of the run.
+    SchedulerStats stats;
+
+    // Time spent in each phase of the scheduler's ticks, if SIM_PROFILE is
+    // compiled in.
+    PhaseTimings phases;
+  };
+
+  /**
+   * The outcomes of a batch of Scenarios, along with totals across them.
+   */
+  class BatchResult {
+   public:
+    BatchResult() : completed(0), min_ticks(0), max_ticks(0), mean_ticks(0) { }
+
+    // One result per scenario, in the same order as the scenarios.
+    std::vector<RunResult> runs;
+
+    // Runs which went idle within their max_ticks.
+    size_t completed;
+
+    // Ticks to drain across completed runs.
+    size_t min_ticks, max_ticks;
+    double mean_ticks;
+
+    // Request wait and travel times across all runs, whether or not they
+    // completed.
+    LatencyStats latency;
+
+    // Phase timings summed across all runs.
+    PhaseTimings phases;
+  };
+
+  /**
+   * Runs a single scenario on the calling thread and returns its result. The
+   * run only depends on the scenario, including its seed. If 'latency' is
+   * provided, the run's request wait and travel times are added to it.
+   */
+  RunResult run_scenario(const Scenario &scenario,
+      LatencyStats *latency = NULL);
+
+  /**
+   * As above, but runs on the provided scheduler, which must be for the
+   * scenario's building and in its initial state, either new or reset(). This
+   * saves reallocating a scheduler for every run.
+   */
+  RunResult run_scenario(Scheduler &scheduler, const Scenario &scenario,
+      LatencyStats *latency = NULL);
+
+  /**
+   * Keeps a Scheduler for each thread of a ThreadPool, so that runs in the
+   * same building on the same thread reuse one Scheduler rather than
+   * reallocating all of its state. Each slot may only be used by one thread
+   * at a time, as in ThreadPool::parallel_for_slots().
+   */
+  class SchedulerCache {
+   public:
+    SchedulerCache(size_t slots);
+    virtual ~SchedulerCache() { }
+
+    /**
+     * Returns the provided slot's Scheduler for the scenario's building, in
+     * its initial state. The Scheduler is reset() if the slot's last run was
+     * in the same building, and replaced otherwise.
+     */
+    Scheduler &get(size_t slot, const Scenario &scenario);
+
+    /**
+     * Returns the number of Schedulers which have been created, across all
+     * slots.
+     */
+    size_t created() const;
+
+   private:
+    std::vector<std::unique_ptr<Scheduler>> schedulers_;
+
+    // Each slot's building, and how many Schedulers it has created.
+    std::vector<floor_t> floors_;
+    std::vector<size_t> elevators_;
+    std::vector<size_t> created_;
+  };
+
+  /**
+   * Runs batches of independent scenarios across a pool of threads. Scenarios
+   * are spread across the threads, and threads which finish early steal
+   * scenarios from the others.
+   */
+  class BatchRunner {
+   public:
+    /**
+     * Creates a runner with the provided number of threads. A value of 0 uses
+     * one thread per hardware core.
+     */
+    BatchRunner(size_t threads = 0);
+    virtual ~BatchRunner() { }
+
+    /**
+     * Runs all of the provided scenarios, returning once they've finished.
+     */
+    BatchResult run(const std::vector<Scenario> &scenarios);
+
+    /**
+     * Returns the per-thread Schedulers, which are kept between batches.
+     */
+    const SchedulerCache &schedulers() const {
+      return schedulers_;
+    }
+
+   private:
+    ThreadPool pool_;
+    SchedulerCache schedulers_;
+  };
+}
+
+#endif /* _sim_batch_h_ */
@@ -0,0 +1,183 @@
+#include "sim/building.h"
+#include "sim/logging.h"
+
+#include <cassert>
+
+std::vector<sim::ZoneConfig> sim::split_zones(floor_t floors, size_t zones,
+    size_t elevators) {
+  std::vector<ZoneConfig> configs;
+  for (size_t i = 1; i <= zones; ++i) {
+    // Spread the floors above the ground floor evenly.
+    floor_t top = (floors - 1) * i / zones;
+    if (top > (configs.empty() ? 0 : configs.back().top)) {
+      configs.push_back(ZoneConfig(top, elevators));
+    }
+  }
+  return configs;
+}
+
+sim::Building::Building(const std::vector<ZoneConfig> &zones,
+    size_t threads/*=1*/)
+  : floors_(0),
+    tick_(1),
+    transfers_(0) {
+  assert(!zones.empty());
+  floor_t bottom = 0;
+  zones_.resize(zones.size());
+  for (size_t i = 0; i < zones.size(); ++i) {
+    assert(zones[i].top > bottom);
+    Zone &zone = zones_[i];
+    zone.bottom = bottom;
+    floor_t floors = zones[i].top - bottom + 1;
+    zone.scheduler.reset(new Scheduler(floors, zones[i].elevators));
+    zone.scheduler->set_arrivals(&zone.arrivals);
+    zone.legs.resize(floors);
+    zone.leg_count = 0;
+    bottom = zones[i].top;
+  }
+  floors_ = bottom + 1;
+  if (threads != 1) {
+    pool_.reset(new ThreadPool(threads));
+  }
+}
+
+sim::Building::~Building() {
+}
+
+bool sim::Building::insert_request(floor_t source, floor_t dest) {
+  if (source >= floors_ || dest >= floors_ || source == dest) {
+    // Invalid input, same as Scheduler::insert_request()
+    return false;
+  }
+  insert_leg(source, dest, tick_);
+  return true;
+}
+
+void sim::Building::insert_leg(floor_t source, floor_t dest,
+    size_t trip_tick) {
+  Zone &zone = zones_[zone_of(source, dest)];
+  floor_t top = zone.bottom + zone.legs.size() - 1;
+  // Ride as far as the zone goes towards the destination.
+  floor_t leg_dest = dest;
+  if (leg_dest > top) {
+    leg_dest = top;
+  } else if (leg_dest < zone.bottom) {
+    leg_dest = zone.bottom;
+  }
+
+  Leg leg;
+  leg.dest = leg_dest - zone.bottom;
+  leg.inserted_tick = zone.scheduler->tick_count() + 1;
+  leg.trip_tick = trip_tick;
+  leg.trip_dest = dest;
+  // This may be merged with an identical request which is already waiting,
+  // in which case the passenger rides along with it.
+  zone.scheduler->insert_request(source - zone.bottom, leg.dest);
+  zone.legs[source - zone.bottom].push_back(leg);
+  ++zone.leg_count;
+}
+
+void sim::Building::tick() {
+  SIM_INFO("=== Start of building tick %lu", tick_);
+  if (pool_) {
+    pool_->parallel_for(zones_.size(), [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        zones_[i].scheduler->tick();
+      }
+    });
+  } else {
+    for (Zone &zone : zones_) {
+      zone.scheduler->tick();
+    }
+  }
+
+  // Every zone has finished the tick, so hand over transfers in zone order.
+  for (Zone &zone : zones_) {
+    for (const Arrival &arrival : zone.arrivals) {
+      finish_legs(zone, arrival);
+    }
+    zone.arrivals.clear();
+  }
+  SIM_INFO("=== End of building tick %lu", tick_);
+  ++tick_;
+}
+
+void sim::Building::finish_legs(Zone &zone, const Arrival &arrival) {
+  /* The arrival covers every leg which was merged into the same request
+   * before it was picked up. Legs are kept in the order they were inserted,
+   * so if another car carrying the same request overtakes this one, its
+   * passengers are the ones treated as having arrived first. */
+  std::vector<Leg> &legs = zone.legs[arrival.source];
+  floor_t floor = zone.bottom + arrival.dest;
+  size_t kept = 0;
+  for (size_t i = 0; i < legs.size(); ++i) {
+    const Leg &leg = legs[i];
+    if (leg.dest != arrival.dest || leg.inserted_tick > arrival.pickup_tick) {
+      legs[kept++] = leg;
+      continue;
+    }
+    --zone.leg_count;
+    if (leg.trip_dest == floor) {
+      trip_latency_.record(arrival.dropoff_tick - leg.trip_tick);
+    } else {
+      SIM_INFO("  Transfer at floor %lu towards floor %lu",
+          floor, leg.trip_dest);
+      insert_leg(floor, leg.trip_dest, leg.trip_tick);
+      ++transfers_;
+    }
+  }
+  legs.resize(kept);
+}
+
+size_t sim::Building::tick_count() const {
+  return tick_ - 1;
+}
+
+bool sim::Building::idle() const {
+  for (const Zone &zone : zones_) {
+    if (zone.leg_count != 0 || !zone.scheduler->idle()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+sim::floor_t sim::Building::floors() const {
+  return floors_;
+}
+
+size_t sim::Building::zone_count() const {
+  return zones_.size();
+}
+
+size_t sim::Building::zone_of(floor_t floor, floor_t dest) const {
+  /* A sky lobby belongs to the zones on both sides of it. Going up, it's
+   * served by the zone above, and going down, by the zone below. */
+  for (size_t i = 0; i < zones_.size(); ++i) {
+    floor_t top = zones_[i].bottom + zones_[i].legs.size() - 1;
+    if (floor < top || (floor == top && dest < floor)) {
+      return i;
+    }
+  }
+  return zones_.size() - 1;
+}
+
+sim::floor_t sim::Building::zone_bottom(size_t zone) const {
+  return zones_[zone].bottom;
+}
+
+sim::Scheduler &sim::Building::zone(size_t zone) {
+  return *zones_[zone].scheduler;
+}
+
+const sim::Scheduler &sim::Building::zone(size_t zone) const {
+  return *zones_[zone].scheduler;
+}
+
+const sim::Histogram &sim::Building::trip_latency() const {
+  return trip_latency_;
+}
+
+size_t sim::Building::transfers() const {
+  return transfers_;
+}
@@ -0,0 +1,164 @@
+#ifndef _sim_building_h_
+#define _sim_building_h_
+
+#include <memory>
+#include <vector>
+
+#include "sim/histogram.h"
+#include "sim/scheduler.h"
+#include "sim/thread_pool.h"
+
+namespace sim {
+
+  /**
+   * One zone of a Building: a bank of elevators which serves a contiguous
+   * range of floors.
+   */
+  class ZoneConfig {
+   public:
+    ZoneConfig(floor_t top = 0, size_t elevators = 0)
+      : top(top), elevators(elevators) { }
+
+    // The highest floor served by the zone. The zone's lowest floor is the
+    // top of the zone below it, or floor 0 for the first zone.
+    floor_t top;
+
+    // The number of elevators in the zone's bank.
+    size_t elevators;
+  };
+
+  /**
+   * Returns 'zones' zones of roughly equal height covering floors [0, floors),
+   * each with the provided number of elevators.
+   */
+  std::vector<ZoneConfig> split_zones(floor_t floors, size_t zones,
+      size_t elevators);
+
+  /**
+   * A tall building which is split into zones, each with its own Scheduler
+   * and bank of elevators. Neighbouring zones share a floor, the sky lobby,
+   * where passengers change between banks.
+   *
+   * Trips within a zone go straight to that zone's scheduler. Trips which
+   * cross zones are split into legs: the passenger rides to the sky lobby
+   * towards their destination, and once they've been dropped off there, the
+   * next leg is inserted into the neighbouring zone. Transfers are inserted
+   * after the tick in which the passenger arrived at the lobby, so they're
+   * picked up from the next tick on.
+   *
+   * Each tick runs all of the zones in parallel, then hands over any
+   * transfers once they've all finished. Results don't depend on the number
+   * of threads.
+   */
+  class Building {
+   public:
+    /**
+     * Creates a building with the provided zones, in ascending order of their
+     * 'top' floors. Zones are ticked on the provided number of threads, or
+     * one thread per hardware core if it's 0.
+     */
+    Building(const std::vector<ZoneConfig> &zones, size_t threads = 1);
+    virtual ~Building();
+
+    /**
+     * Inserts a new trip from 'source' to 'dest', which may be in different
+     * zones. Returns false if the trip is invalid. Unlike Scheduler, identical
+     * trips are still counted separately towards trip latency, even though
+     * the zone scheduler merges them.
+     */
+    bool insert_request(floor_t source, floor_t dest);
+
+    /**
+     * Runs the simulation for a step in every zone, then hands over any
+     * passengers who have reached a sky lobby to the next zone.
+     */
+    void tick();
+
+    /**
+     * Returns the number of ticks which have elapsed so far.
+     */
+    size_t tick_count() const;
+
+    /**
+     * Returns whether every zone is idle, with no passengers left to carry.
+     */
+    bool idle() const;
+
+    /**
+     * Returns the number of floors in the building.
+     */
+    floor_t floors() const;
+
+    /**
+     * Returns the number of zones, and the zone which serves a floor on the
+     * way to the provided destination.
+     */
+    size_t zone_count() const;
+    size_t zone_of(floor_t floor, floor_t dest) const;
+
+    /**
+     * Returns the lowest floor served by a zone.
+     */
+    floor_t zone_bottom(size_t zone) const;
+
+    /**
+     * Returns the scheduler for a zone, eg to change its dispatch. Its floors
+     * are numbered from the bottom of the zone.
+     */
+    Scheduler &zone(size_t zone);
+    const Scheduler &zone(size_t zone) const;
+
+    /**
+     * Returns the number of ticks taken by completed trips, from
+     * insert_request() until the passenger was dropped off at their final
+     * destination, including any waits at sky lobbies.
+     */
+    const Histogram &trip_latency() const;
+
+    /**
+     * Returns the number of transfers between zones so far.
+     */
+    size_t transfers() const;
+
+   private:
+    /**
+     * A passenger's current leg within a zone, in the zone's floor numbers.
+     */
+    class Leg {
+     public:
+      floor_t dest;
+
+      // The zone's tick when the leg was inserted.
+      size_t inserted_tick;
+
+      // The building's tick when the trip began, and its final destination.
+      size_t trip_tick;
+      floor_t trip_dest;
+    };
+
+    class Zone {
+     public:
+      floor_t bottom;
+      std::unique_ptr<Scheduler> scheduler;
+
+      // Legs which haven't reached their destination yet, by source floor.
+      std::vector<std::vector<Leg> > legs;
+      size_t leg_count;
+
+      // Requests dropped off during the current tick.
+      std::vector<Arrival> arrivals;
+    };
+
+    void insert_leg(floor_t source, floor_t dest, size_t trip_tick);
+    void finish_legs(Zone &zone, const Arrival &arrival);
+
+    std::vector<Zone> zones_;
+    floor_t floors_;
+    size_t tick_;
+    std::unique_ptr<ThreadPool> pool_;
+    Histogram trip_latency_;
+    size_t transfers_;
+  };
+}
+
+#endif /* _sim_building_h_ */
@@ -0,0 +1,81 @@
+#ifndef _sim_dispatch_h_
+#define _sim_dispatch_h_
+
+#include <utility>
+#include <vector>
+
+#include "sim/logging.h"
+#include "sim/types.h"
+
+namespace sim {
+
+  /**
+   * Dispatch policies decide which of the elevators that approved a pickup
+   * should get it. A policy is a class with a score_t typedef and a static
+   * score() function which scores an approving car. The lowest score wins,
+   * and ties go to the lowest index.
+   *
+   * Policies are plugged into select_car() as a template parameter rather
+   * than through virtual calls, so the scoring is inlined into the approval
+   * loop. To try a new rule, write a policy and pass it to
+   * Scheduler::set_dispatch_policy().
+   */
+
+  /**
+   * Prefers the car with the fewest queued requests. This is the default.
+   */
+  class FewestRequestsPolicy {
+   public:
+    typedef size_t score_t;
+
+    template <typename Car>
+    static score_t score(const Car &car, floor_t floor, Direction direction) {
+      return car.request_count();
+    }
+  };
+
+  /**
+   * Prefers the car which would reach the pickup soonest, then the one with
+   * the fewest queued requests.
+   */
+  class LowestEtaPolicy {
+   public:
+    typedef std::pair<floor_t, size_t> score_t;
+
+    template <typename Car>
+    static score_t score(const Car &car, floor_t floor, Direction direction) {
+      return score_t(car.eta(floor, direction), car.request_count());
+    }
+  };
+
+  /**
+   * Returns the index of the car which 'Policy' picks for the provided
+   * pickup, among the cars which approve it, or -1 if none of them do. 'Car'
+   * must provide approve_request() along with whatever the policy uses, as
+   * Elevator does.
+   */
+  template <typename Policy, typename Car>
+  int select_car(std::vector<Car> &cars, floor_t floor, Direction direction) {
+    int best_index = -1;
+    typename Policy::score_t best_score = typename Policy::score_t();
+    for (size_t i = 0; i < cars.size(); ++i) {
+      Car &car = cars[i];
+      if (car.approve_request(floor, direction)) {
+        SIM_DEBUG("  Pickup by elevator %lu (requests=%lu) at floor %lu approved",
+            i, car.request_count(), floor);
+        // This car will accept the request, but is it better than our other
+        // options?
+        typename Policy::score_t score = Policy::score(car, floor, direction);
+        if (best_index < 0 || score < best_score) {
+          best_index = i;
+          best_score = score;
+        }
+      } else {
+        SIM_DEBUG("  Pickup by elevator %lu at floor %lu declined", i, floor);
+      }
+    }
+    return best_index;
+  }
+}
+
+#endif /* _sim_dispatch_h_ */
@@ -1,8 +1,18 @@
 #include "sim/elevator.h"
+#include "sim/hash.h"
 #include "sim/logging.h"
 
-sim::Elevator::Elevator(floor_t starting_floor/*=0*/)
-  : floor_(starting_floor) { }
+#include <algorithm>
+#include <cassert>
+
+sim::Elevator::Elevator(floor_t starting_floor/*=0*/, floor_t floors/*=0*/,
+    Arena *arena/*=NULL*/)
+  : floor_(starting_floor),
+    floor_requests_(floors, arena),
+    lowest_request_(0),
+    highest_request_(0),
+    accept_direction(Direction::EITHER),
+    queue_hash_(0) { }
 
 sim::floor_t sim::Elevator::floor() const {
   return floor_;
@@ -25,7 +35,7 @@ bool sim::Elevator::approve_request(floor_t req_floor, Direction req_direction)
       if (req_floor < floor_ || req_direction != Direction::UP) {
         // Elevator is going up, but the request is below the elevator's current
         // location. Denied.
-        debug("    Floor %lu/%s denied: we're going UP from floor %lu.",
+        SIM_DEBUG("    Floor %lu/%s denied: we're going UP from floor %lu.",
             req_floor, string(req_direction), floor_);
         return false;
       }
@@ -34,7 +44,7 @@ bool sim::Elevator::approve_request(floor_t req_floor, Direction req_direction)
       if (req_floor > floor_ || req_direction != Direction::DOWN) {
         // Elevator is going down, but the request is above the elevator's
         // current location. Denied.
-        debug("    Floor %lu/%s denied: we're going DOWN from floor %lu.",
+        SIM_DEBUG("    Floor %lu/%s denied: we're going DOWN from floor %lu.",
             req_floor, string(req_direction), floor_);
         return false;
       }
@@ -44,17 +54,78 @@ bool sim::Elevator::approve_request(floor_t req_floor, Direction req_direction)
       break;
   }
 
-  debug("    Floor %lu/%s approved: we were going %s from %lu.",
+  SIM_DEBUG("    Floor %lu/%s approved: we were going %s from %lu.",
       req_floor, string(req_direction), string(cur_direction), floor_);
   return true;
 }
 
+bool sim::Elevator::in_path(floor_t req_floor, Direction req_direction) const {
+  switch (direction()) {
+    case Direction::UP:
+      return req_floor >= floor_ && req_direction == Direction::UP;
+    case Direction::DOWN:
+      return req_floor <= floor_ && req_direction == Direction::DOWN;
+    case Direction::EITHER:
+      break;
+  }
+  return true;
+}
+
+sim::floor_t sim::Elevator::eta(floor_t req_floor,
+    Direction req_direction) const {
+  switch (direction()) {
+    case Direction::UP:
+      {
+        /* Any requests below us were inserted while we were idle, so we'll
+         * head down to the lowest one before sweeping up. Every queued stop
+         * below the requested floor costs a tick for the door. */
+        floor_t low = std::min(floor_, lowest_request_);
+        size_t stops;
+        if (req_floor > highest_request_) {
+          stops = floor_requests_.size();
+        } else if (req_floor <= lowest_request_) {
+          stops = 0;
+        } else {
+          stops = floor_requests_.count_below(req_floor);
+        }
+        return (floor_ - low) + (req_floor - low) + stops;
+      }
+    case Direction::DOWN:
+      {
+        // Same as UP, mirrored.
+        floor_t high = std::max(floor_, highest_request_);
+        size_t stops;
+        if (req_floor < lowest_request_) {
+          stops = floor_requests_.size();
+        } else if (req_floor >= highest_request_) {
+          stops = 0;
+        } else {
+          stops = floor_requests_.size()
+            - floor_requests_.count_below(req_floor + 1);
+        }
+        return (high - floor_) + (high - req_floor) + stops;
+      }
+    case Direction::EITHER:
+      break;
+  }
+  // Idle, so we'll head straight there.
+  return (floor_ < req_floor) ? req_floor - floor_ : floor_ - req_floor;
+}
+
 bool sim::Elevator::insert_request(floor_t floor, Direction req_direction) {
   if (!approve_request(floor, req_direction)) {
     return false;
   }
-  debug("    Floor %lu inserted.", floor);
-  floor_requests_.insert(floor);
+  SIM_DEBUG("    Floor %lu inserted.", floor);
+  if (floor_requests_.empty()) {
+    lowest_request_ = highest_request_ = floor;
+  } else {
+    lowest_request_ = std::min(lowest_request_, floor);
+    highest_request_ = std::max(highest_request_, floor);
+  }
+  if (floor_requests_.insert(floor)) {
+    queue_hash_ ^= hash_key(HASH_ELEVATOR_QUEUE, floor);
+  }
   accept_direction = req_direction;
   return true;
 }
@@ -62,46 +133,41 @@ bool sim::Elevator::insert_request(floor_t floor, Direction req_direction) {
 sim::Action sim::Elevator::tick() {
   if (floor_requests_.empty()) {
     // Nothing in request queue, do nothing.
-    debug("    Elevator queue empty at floor %lu.", floor_);
+    SIM_DEBUG("    Elevator queue empty at floor %lu.", floor_);
     return Action::IDLE;
   }
 
   // Get the next floor to be served from the queue.
-  floor_t nearest_request;
-  switch (direction()) {
-    case Direction::UP:
-      // Moving to lowest floor in queue
-      nearest_request = *floor_requests_.begin();
-      break;
-    case Direction::DOWN:
-      // Moving to highest floor in queue
-      nearest_request = *floor_requests_.rbegin();
-      break;
-    case Direction::EITHER:
-      // Should only be one request
-      nearest_request = *floor_requests_.begin();
-      break;
-  }
+  floor_t nearest_request = next_request();
 
   // Perform work depending on where the next floor is located, relative to the
   // elevator's current position.
   if (floor_ < nearest_request) {
     // Move up a floor
     ++floor_;
-    debug("    Moved up to floor %lu towards floor %lu (%lu in queue).",
+    SIM_DEBUG("    Moved up to floor %lu towards floor %lu (%lu in queue).",
         floor_, nearest_request, floor_requests_.size());
     return Action::FLOOR_UP;
   } else if (floor_ > nearest_request) {
     // Move down a floor
     --floor_;
-    debug("    Moved down to floor %lu towards floor %lu (%lu in queue).",
+    SIM_DEBUG("    Moved down to floor %lu towards floor %lu (%lu in queue).",
         floor_, nearest_request, floor_requests_.size());
     return Action::FLOOR_DOWN;
   } else {
     // Currently at a requested floor. Open doors and complete the request by
     // removing it from the set.
     floor_requests_.erase(floor_);
-    debug("    Arrived at floor %lu (%lu still in queue).",
+    queue_hash_ ^= hash_key(HASH_ELEVATOR_QUEUE, floor_);
+    // The served floor was whichever end of the queue we were heading for.
+    if (floor_requests_.empty()) {
+      // Nothing left to track.
+    } else if (floor_ == lowest_request_) {
+      lowest_request_ = floor_requests_.next(floor_);
+    } else {
+      highest_request_ = floor_requests_.previous(floor_);
+    }
+    SIM_DEBUG("    Arrived at floor %lu (%lu still in queue).",
         floor_, floor_requests_.size());
     return Action::DOOR_OPEN;
   }
@@ -110,3 +176,89 @@ sim::Action sim::Elevator::tick() {
 size_t sim::Elevator::request_count() const {
   return floor_requests_.size();
 }
+
+uint64_t sim::Elevator::hash() const {
+  return queue_hash_ ^ hash_key(HASH_ELEVATOR_FLOOR, floor_)
+    ^ hash_key(HASH_ELEVATOR_DIRECTION, direction());
+}
+
+uint64_t sim::Elevator::compute_hash() const {
+  uint64_t hash = hash_key(HASH_ELEVATOR_FLOOR, floor_)
+    ^ hash_key(HASH_ELEVATOR_DIRECTION, direction());
+  for (floor_t floor : floor_requests_) {
+    hash ^= hash_key(HASH_ELEVATOR_QUEUE, floor);
+  }
+  return hash;
+}
+
+sim::floor_t sim::Elevator::distance_to_next_request() const {
+  if (floor_requests_.empty()) {
+    return 0;
+  }
+  floor_t nearest_request = next_request();
+  return (floor_ < nearest_request)
+    ? nearest_request - floor_ : floor_ - nearest_request;
+}
+
+sim::Direction sim::Elevator::travel_direction() const {
+  if (floor_requests_.empty()) {
+    return Direction::EITHER;
+  }
+  floor_t nearest_request = next_request();
+  if (floor_ < nearest_request) {
+    return Direction::UP;
+  } else if (floor_ > nearest_request) {
+    return Direction::DOWN;
+  }
+  return Direction::EITHER;
+}
+
+void sim::Elevator::skip_floors(floor_t floors) {
+  if (floors == 0) {
+    return;
+  }
+  floor_t nearest_request = next_request();
+  if (floor_ < nearest_request) {
+    assert(floors <= nearest_request - floor_);
+    floor_ += floors;
+  } else {
+    assert(floors <= floor_ - nearest_request);
+    floor_ -= floors;
+  }
+  SIM_DEBUG("    Skipped %lu floors to floor %lu towards floor %lu.",
+      floors, floor_, nearest_request);
+}
+
+sim::Elevator::State sim::Elevator::state() const {
+  State state;
+  state.floor = floor_;
+  state.lowest_request = lowest_request_;
+  state.highest_request = highest_request_;
+  state.accept_direction = accept_direction;
+  state.queue_hash = queue_hash_;
+  return state;
+}
+
+void sim::Elevator::restore(const State &state) {
+  floor_ = state.floor;
+  lowest_request_ = state.lowest_request;
+  highest_request_ = state.highest_request;
+  accept_direction = state.accept_direction;
+  queue_hash_ = state.queue_hash;
+  floor_requests_.recount();
+}
+
+sim::floor_t sim::Elevator::next_request() const {
+  switch (direction()) {
+    case Direction::UP:
+      // Moving to lowest floor in queue
+      return lowest_request_;
+    case Direction::DOWN:
+      // Moving to highest floor in queue
+      return highest_request_;
+    case Direction::EITHER:
+      // Should only be one request
+      break;
+  }
+  return lowest_request_;
+}
@@ -12,7 +12,17 @@ namespace sim {
    */
   class Elevator {
    public:
-    Elevator(floor_t starting_floor = 0);
+    /**
+     * Creates an elevator at the provided floor. The request queue is sized
+     * for a building with the provided number of floors, and is stored in the
+     * provided arena, or on the heap if it's NULL.
+     */
+    Elevator(floor_t starting_floor = 0, floor_t floors = 0,
+        Arena *arena = NULL);
+    Elevator(const Elevator &other) = default;
+    Elevator(Elevator &&other) = default;
+    Elevator &operator=(const Elevator &other) = default;
+    Elevator &operator=(Elevator &&other) = default;
     virtual ~Elevator() { }
 
     /**
@@ -35,6 +45,20 @@ namespace sim {
      */
     bool approve_request(floor_t floor, Direction req_direction);
 
+    /**
+     * Same as approve_request(), except that nothing is logged.
+     */
+    bool in_path(floor_t floor, Direction req_direction) const;
+
+    /**
+     * Returns the number of ticks before this elevator would open its doors at
+     * the provided floor, if the request were inserted now: the floors it
+     * would travel, plus one tick for each queued stop it would make along
+     * the way. The request must be in_path(). This is constant time unless
+     * the floor falls between queued stops.
+     */
+    floor_t eta(floor_t floor, Direction req_direction) const;
+
     /**
      * Inserts the provided request into this elevator's queue, or returns false
      * if it's rejected. See also approve_floor().
@@ -52,13 +76,74 @@ namespace sim {
      */
     Action tick();
 
+    /**
+     * Returns the number of floors this elevator will travel before it next
+     * opens its doors, or 0 if it's idle or already at its next requested
+     * floor.
+     */
+    floor_t distance_to_next_request() const;
+
+    /**
+     * Returns the way this elevator is moving towards its next request, or
+     * EITHER if it's idle or already at its next requested floor. This may
+     * be against direction(), while it travels to the far end of its queue
+     * before sweeping back.
+     */
+    Direction travel_direction() const;
+
+    /**
+     * Moves the elevator the provided number of floors towards its next
+     * request, as if tick() had been called that many times. This must not be
+     * more than distance_to_next_request().
+     */
+    void skip_floors(floor_t floors);
+
     /**
      * Returns the number of requests currently being serviced by this
      * elevator.
      */
     size_t request_count() const;
 
+    /**
+     * Returns a hash of the elevator's floor, direction() and queued floors.
+     * Elevators in the same state have the same hash, however they got
+     * there. The queued floors' part is kept up to date as they change, so
+     * this is constant time.
+     */
+    uint64_t hash() const;
+
+    /**
+     * Works out the same value as hash() from scratch, to check it.
+     */
+    uint64_t compute_hash() const;
+
+    /**
+     * The position and heading of an elevator: everything apart from its
+     * queued floors, which live in the Arena that it was created with. This
+     * is trivially copyable, so that checkpointing a Scheduler can copy it
+     * along with the arena's contents.
+     */
+    class State {
+     public:
+      floor_t floor, lowest_request, highest_request;
+      Direction accept_direction;
+      uint64_t queue_hash;
+    };
+
+    /**
+     * Returns the elevator's current State.
+     */
+    State state() const;
+
+    /**
+     * Restores a State from state(). The queued floors must already have been
+     * restored in place, by restoring the Arena which holds them.
+     */
+    void restore(const State &state);
+
    private:
+    floor_t next_request() const;
+
     /**
      * The current position of this elevator.
      */
@@ -70,10 +155,24 @@ namespace sim {
      */
     floor_set_t floor_requests_;
 
+    /**
+     * The lowest and highest floors in 'floor_requests_', kept up to date as
+     * requests are inserted and served so that they don't need to be searched
+     * for. Only meaningful while there are requests.
+     */
+    floor_t lowest_request_, highest_request_;
+
     /**
      * The direction of requests that are currently being served.
      */
     Direction accept_direction;
+
+    /**
+     * Zobrist hash of the floors in 'floor_requests_' (see sim/hash.h). The
+     * floor and direction are only hashed when hash() is called, so that
+     * moving between floors costs nothing extra.
+     */
+    uint64_t queue_hash_;
   };
 }
 
@@ -0,0 +1,209 @@
+#include "sim/fleet.h"
+
+#include <cassert>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIM_FLEET_LANES 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIM_FLEET_LANES 4
+#else
+#define SIM_FLEET_LANES 1
+#endif
+
+namespace {
+  // Key for elevators which declined the pickup. Real request counts are
+  // always lower than this.
+  const int32_t DECLINED = std::numeric_limits<int32_t>::max();
+
+  // Direction value for padding lanes, which never approves anything.
+  const int32_t PADDING = -1;
+
+  size_t padded(size_t elevators) {
+    return (elevators + SIM_FLEET_LANES - 1)
+      / SIM_FLEET_LANES * SIM_FLEET_LANES;
+  }
+}
+
+sim::Fleet::Fleet(size_t elevators/*=0*/)
+  : size_(elevators),
+    floors_(padded(elevators), 0),
+    directions_(padded(elevators), PADDING),
+    counts_(padded(elevators), 0) {
+  for (size_t i = 0; i < elevators; ++i) {
+    directions_[i] = Direction::EITHER;
+  }
+}
+
+size_t sim::Fleet::size() const {
+  return size_;
+}
+
+void sim::Fleet::update(size_t index, const Elevator &elevator) {
+  assert(index < size_);
+  assert(elevator.floor() < floor_t(DECLINED));
+  assert(elevator.request_count() < size_t(DECLINED));
+  floors_[index] = elevator.floor();
+  directions_[index] = elevator.direction();
+  counts_[index] = elevator.request_count();
+}
+
+#if defined(__AVX2__)
+
+int sim::Fleet::select(floor_t floor, Direction direction) const {
+  assert(floor < floor_t(DECLINED));
+  const __m256i req_floor = _mm256_set1_epi32(floor);
+  const __m256i req_direction = _mm256_set1_epi32(direction);
+  const __m256i either = _mm256_set1_epi32(Direction::EITHER);
+  const __m256i declined = _mm256_set1_epi32(DECLINED);
+  const size_t lanes = floors_.size();
+
+  /* Pass 1: Build each elevator's key (request count if approved, DECLINED
+   * otherwise) and find the lowest key. Elevators going the same way as the
+   * request approve unless they've already passed the pickup floor. */
+  __m256i best = declined;
+  for (size_t i = 0; i < lanes; i += 8) {
+    __m256i floors = _mm256_loadu_si256((const __m256i*)&floors_[i]);
+    __m256i directions = _mm256_loadu_si256((const __m256i*)&directions_[i]);
+    __m256i counts = _mm256_loadu_si256((const __m256i*)&counts_[i]);
+    __m256i passed = (direction == Direction::DOWN)
+      ? _mm256_cmpgt_epi32(req_floor, floors)
+      : _mm256_cmpgt_epi32(floors, req_floor);
+    __m256i approved = _mm256_or_si256(
+        _mm256_cmpeq_epi32(directions, either),
+        _mm256_andnot_si256(passed,
+          _mm256_cmpeq_epi32(directions, req_direction)));
+    best = _mm256_min_epi32(best,
+        _mm256_blendv_epi8(declined, counts, approved));
+  }
+  __m128i best4 = _mm_min_epi32(
+      _mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+  best4 = _mm_min_epi32(best4, _mm_shuffle_epi32(best4, _MM_SHUFFLE(1, 0, 3, 2)));
+  best4 = _mm_min_epi32(best4, _mm_shuffle_epi32(best4, _MM_SHUFFLE(2, 3, 0, 1)));
+  int32_t best_count = _mm_cvtsi128_si32(best4);
+  if (best_count == DECLINED) {
+    return -1;
+  }
+
+  // Pass 2: Find the lowest index which has the lowest key.
+  const __m256i target = _mm256_set1_epi32(best_count);
+  for (size_t i = 0; i < lanes; i += 8) {
+    __m256i floors = _mm256_loadu_si256((const __m256i*)&floors_[i]);
+    __m256i directions = _mm256_loadu_si256((const __m256i*)&directions_[i]);
+    __m256i counts = _mm256_loadu_si256((const __m256i*)&counts_[i]);
+    __m256i passed = (direction == Direction::DOWN)
+      ? _mm256_cmpgt_epi32(req_floor, floors)
+      : _mm256_cmpgt_epi32(floors, req_floor);
+    __m256i approved = _mm256_or_si256(
+        _mm256_cmpeq_epi32(directions, either),
+        _mm256_andnot_si256(passed,
+          _mm256_cmpeq_epi32(directions, req_direction)));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+          _mm256_and_si256(approved, _mm256_cmpeq_epi32(counts, target))));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  assert(false);
+  return -1;
+}
+
+#elif defined(__SSE2__)
+
+namespace {
+  inline __m128i approved_sse2(const int32_t *floor_lanes,
+      const int32_t *direction_lanes, __m128i req_floor, __m128i req_direction,
+      bool down) {
+    __m128i floors = _mm_loadu_si128((const __m128i*)floor_lanes);
+    __m128i directions = _mm_loadu_si128((const __m128i*)direction_lanes);
+    __m128i passed = down
+      ? _mm_cmpgt_epi32(req_floor, floors)
+      : _mm_cmpgt_epi32(floors, req_floor);
+    return _mm_or_si128(
+        _mm_cmpeq_epi32(directions, _mm_set1_epi32(sim::Direction::EITHER)),
+        _mm_andnot_si128(passed, _mm_cmpeq_epi32(directions, req_direction)));
+  }
+
+  // SSE2 lacks a 32-bit min and blend, so build them from compares and masks.
+  inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+}
+
+int sim::Fleet::select(floor_t floor, Direction direction) const {
+  assert(floor < floor_t(DECLINED));
+  const __m128i req_floor = _mm_set1_epi32(floor);
+  const __m128i req_direction = _mm_set1_epi32(direction);
+  const __m128i declined = _mm_set1_epi32(DECLINED);
+  const bool down = (direction == Direction::DOWN);
+  const size_t lanes = floors_.size();
+
+  // Pass 1: Find the lowest key. See the AVX2 version above.
+  __m128i best = declined;
+  for (size_t i = 0; i < lanes; i += 4) {
+    __m128i approved = approved_sse2(
+        &floors_[i], &directions_[i], req_floor, req_direction, down);
+    __m128i keys = select_sse2(approved,
+        _mm_loadu_si128((const __m128i*)&counts_[i]), declined);
+    best = select_sse2(_mm_cmplt_epi32(keys, best), keys, best);
+  }
+  __m128i other = _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2));
+  best = select_sse2(_mm_cmplt_epi32(other, best), other, best);
+  other = _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1));
+  best = select_sse2(_mm_cmplt_epi32(other, best), other, best);
+  int32_t best_count = _mm_cvtsi128_si32(best);
+  if (best_count == DECLINED) {
+    return -1;
+  }
+
+  // Pass 2: Find the lowest index which has the lowest key.
+  const __m128i target = _mm_set1_epi32(best_count);
+  for (size_t i = 0; i < lanes; i += 4) {
+    __m128i approved = approved_sse2(
+        &floors_[i], &directions_[i], req_floor, req_direction, down);
+    __m128i counts = _mm_loadu_si128((const __m128i*)&counts_[i]);
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(
+          _mm_and_si128(approved, _mm_cmpeq_epi32(counts, target))));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  assert(false);
+  return -1;
+}
+
+#else
+
+int sim::Fleet::select(floor_t floor, Direction direction) const {
+  return select_scalar(floor, direction);
+}
+
+#endif
+
+int sim::Fleet::select_scalar(floor_t floor, Direction direction) const {
+  // Same rules as Elevator::approve_request().
+  int32_t req_floor = floor;
+  int best_index = -1;
+  for (size_t i = 0; i < size_; ++i) {
+    switch (directions_[i]) {
+      case Direction::UP:
+        if (req_floor < floors_[i] || direction != Direction::UP) {
+          continue;
+        }
+        break;
+      case Direction::DOWN:
+        if (req_floor > floors_[i] || direction != Direction::DOWN) {
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+    if (best_index < 0 || counts_[i] < counts_[best_index]) {
+      best_index = i;
+    }
+  }
+  return best_index;
+}
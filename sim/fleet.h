@@ -0,0 +1,58 @@
+#ifndef _sim_fleet_h_
+#define _sim_fleet_h_
+
+#include <vector>
+
+#include "sim/elevator.h"
+
+namespace sim {
+
+  /**
+   * A structure-of-arrays mirror of the Elevators in a Scheduler, holding only
+   * what's needed to pick an elevator for a pickup: each elevator's floor,
+   * direction and request count. This allows the approval check and the
+   * 'fewest requests' selection to be evaluated for all elevators in a single
+   * SIMD pass (AVX2 or SSE2 depending on build flags, with a scalar fallback),
+   * instead of calling Elevator::approve_request() once per elevator.
+   *
+   * The Fleet doesn't observe the Elevators itself. The owner must call
+   * update() whenever an Elevator's floor, direction or requests change.
+   */
+  class Fleet {
+   public:
+    Fleet(size_t elevators = 0);
+    virtual ~Fleet() { }
+
+    /**
+     * Returns the number of elevators in the fleet.
+     */
+    size_t size() const;
+
+    /**
+     * Copies the current state of the provided Elevator into the fleet.
+     */
+    void update(size_t index, const Elevator &elevator);
+
+    /**
+     * Returns the index of the elevator which would be chosen for the provided
+     * pickup: among the elevators which would approve it, the one with the
+     * fewest requests, with ties going to the lowest index. Returns -1 if no
+     * elevator would approve it. This matches calling approve_request() and
+     * request_count() on each Elevator in order.
+     */
+    int select(floor_t floor, Direction direction) const;
+
+   private:
+    int select_scalar(floor_t floor, Direction direction) const;
+
+    size_t size_;
+
+    /**
+     * Per-elevator lanes, padded to a multiple of the SIMD width. Padding
+     * lanes have a direction which never approves anything.
+     */
+    std::vector<int32_t> floors_, directions_, counts_;
+  };
+}
+
+#endif /* _sim_fleet_h_ */
@@ -0,0 +1,46 @@
+#ifndef _sim_hash_h_
+#define _sim_hash_h_
+
+#include <stdint.h>
+
+#include "sim/random.h"
+
+namespace sim {
+
+  /**
+   * The kinds of state which go into a Scheduler's state hash. Each has its
+   * own set of Zobrist keys.
+   */
+  enum HashKind {
+    HASH_ELEVATOR_FLOOR = 1, // The floor an elevator is at
+    HASH_ELEVATOR_DIRECTION, // An elevator's direction()
+    HASH_ELEVATOR_QUEUE, // A floor in an elevator's queue
+    HASH_ELEVATOR, // An elevator's whole hash, at its index
+    HASH_GROUP_DEST, // A destination in a pickup group
+    HASH_GROUP_ACCEPTED, // A pickup group which an elevator has accepted
+    HASH_GROUP_COUNT // The passengers waiting in a pickup group
+  };
+
+  /**
+   * Returns the Zobrist key for a piece of state: a fixed pseudo-random value
+   * for each kind and index. The hash of some state is the XOR of the keys
+   * of everything in it, so adding or removing one piece is a single XOR
+   * with its key, and the order things happened in doesn't matter. Keys are
+   * worked out as they're needed rather than kept in a table, and are the
+   * same on every platform.
+   */
+  inline uint64_t hash_key(HashKind kind, uint64_t index) {
+    return RandomStream(kind).at(index);
+  }
+
+  /**
+   * Returns the key for a part of the state which keeps its own hash, such
+   * as an elevator, at the provided index. Unlike XORing in the part's hash
+   * directly, two parts which swap states don't cancel each other out.
+   */
+  inline uint64_t hash_part(HashKind kind, uint64_t index, uint64_t hash) {
+    return RandomStream(hash_key(kind, index)).at(hash);
+  }
+}
+
+#endif /* _sim_hash_h_ */
@@ -0,0 +1,58 @@
+#include "sim/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+sim::Histogram::Histogram() {
+  clear();
+}
+
+void sim::Histogram::merge(const Histogram &other) {
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void sim::Histogram::clear() {
+  counts_.fill(0);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+double sim::Histogram::mean() const {
+  if (count_ == 0) {
+    return 0;
+  }
+  return double(sum_) / count_;
+}
+
+uint64_t sim::Histogram::percentile(double percent) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the value we're looking for, counting from 1.
+  uint64_t rank = uint64_t(std::ceil(percent / 100 * count_));
+  rank = std::min(std::max(rank, uint64_t(1)), count_);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(highest_in_bucket(i), max_);
+    }
+  }
+  return max_;
+}
+
+uint64_t sim::Histogram::highest_in_bucket(size_t bucket) {
+  if (bucket < 2 * SUB_COUNT) {
+    return bucket;
+  }
+  int shift = bucket / SUB_COUNT - 1;
+  uint64_t top = bucket - shift * SUB_COUNT;
+  // Wraps around to the largest uint64_t for the very last bucket.
+  return ((top + 1) << shift) - 1;
+}
@@ -0,0 +1,97 @@
+#ifndef _sim_histogram_h_
+#define _sim_histogram_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+
+namespace sim {
+
+  /**
+   * A fixed-size histogram of non-negative integer values, in the style of
+   * HdrHistogram. Values below 128 are counted exactly. Larger values share
+   * log-linear buckets: each power of two is split into 64 sub-buckets, so
+   * reported values are within about 1.6% of the recorded ones, all the way
+   * up to the largest uint64_t.
+   *
+   * Recording is a few integer operations into a fixed array, and never
+   * allocates. The histogram is trivially copyable, so it may be copied or
+   * merged freely, eg to combine results from several threads.
+   */
+  class Histogram {
+   public:
+    Histogram();
+
+    /**
+     * Counts one occurrence of the provided value.
+     */
+    void record(uint64_t value) {
+      ++counts_[bucket(value)];
+      ++count_;
+      sum_ += value;
+      if (value > max_) {
+        max_ = value;
+      }
+    }
+
+    /**
+     * Adds all of the values recorded in another histogram to this one.
+     */
+    void merge(const Histogram &other);
+
+    /**
+     * Forgets all recorded values.
+     */
+    void clear();
+
+    /**
+     * Returns the number of recorded values.
+     */
+    uint64_t count() const {
+      return count_;
+    }
+
+    /**
+     * Returns the largest recorded value, or 0 if none were recorded. This is
+     * exact, rather than rounded to a bucket.
+     */
+    uint64_t max() const {
+      return max_;
+    }
+
+    /**
+     * Returns the mean of the recorded values, or 0 if none were recorded.
+     */
+    double mean() const;
+
+    /**
+     * Returns the value below which the provided percentage (0-100) of
+     * recorded values fall, eg 99.9 for the p999. The result is the highest
+     * value which shares a bucket with that recorded value, but is never
+     * more than max(). Returns 0 if no values were recorded.
+     */
+    uint64_t percentile(double percent) const;
+
+   private:
+    // Each power of two above the exact range is split into 2^SUB_BITS
+    // buckets.
+    static const int SUB_BITS = 6;
+    static const uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+    static const size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    static size_t bucket(uint64_t value) {
+      if (value < 2 * SUB_COUNT) {
+        return value;
+      }
+      int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+      return shift * SUB_COUNT + (value >> shift);
+    }
+
+    static uint64_t highest_in_bucket(size_t bucket);
+
+    std::array<uint64_t, BUCKETS> counts_;
+    uint64_t count_, sum_, max_;
+  };
+}
+
+#endif /* _sim_histogram_h_ */
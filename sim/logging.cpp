@@ -5,15 +5,85 @@
 
 bool sim::verbose_enabled = false;
 
-void sim::debug(const char* format, ...) {
-  if (!verbose_enabled) {
-    return;
+namespace {
+  /**
+   * Log lines which have been written by a thread but not yet printed. Each
+   * thread has its own, so logging never waits on a lock except to write out
+   * a full buffer.
+   */
+  class LogBuffer {
+   public:
+    LogBuffer() : used(0) { }
+    ~LogBuffer() {
+      flush();
+      fflush(stdout);
+    }
+
+    void flush() {
+      if (used != 0) {
+        fwrite(data, 1, used, stdout);
+        used = 0;
+      }
+    }
+
+    // Room for a few hundred lines at a time.
+    char data[64 * 1024];
+    size_t used;
+  };
+
+  thread_local LogBuffer buffer;
+
+  // Length of the "[X] " prefix on each line.
+  const size_t PREFIX = 4;
+
+  int format(char *out, size_t size, char tag,
+      const char *format, va_list args) {
+    if (size <= PREFIX + 1) {
+      return -1;
+    }
+    out[0] = '[';
+    out[1] = tag;
+    out[2] = ']';
+    out[3] = ' ';
+    int body = vsnprintf(out + PREFIX, size - PREFIX, format, args);
+    if (body < 0 || PREFIX + body + 1 >= size) {
+      return -1;
+    }
+    out[PREFIX + body] = '\n';
+    return PREFIX + body + 1;
   }
+}
 
+void sim::log(char tag, const char* format_str, ...) {
   va_list args;
-  va_start(args, format);
-  fprintf(stdout, "[D] ");
-  vfprintf(stdout, format, args);
+  va_start(args, format_str);
+  int written = format(buffer.data + buffer.used,
+      sizeof(buffer.data) - buffer.used, tag, format_str, args);
+  va_end(args);
+  if (written >= 0) {
+    buffer.used += written;
+    return;
+  }
+
+  // Didn't fit: Make room and try again.
+  buffer.flush();
+  va_start(args, format_str);
+  written = format(buffer.data, sizeof(buffer.data), tag, format_str, args);
+  va_end(args);
+  if (written >= 0) {
+    buffer.used = written;
+    return;
+  }
+
+  // Too big for the buffer at all: Print it directly.
+  va_start(args, format_str);
+  fprintf(stdout, "[%c] ", tag);
+  vfprintf(stdout, format_str, args);
   va_end(args);
   fprintf(stdout, "\n");
 }
+
+void sim::flush_log() {
+  buffer.flush();
+  fflush(stdout);
+}
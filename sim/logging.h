@@ -1,10 +1,49 @@
 #ifndef _sim_logging_h_
 #define _sim_logging_h_
 
+/* Log levels. The level is selected at compile time by defining SIM_LOG_LEVEL
+ * (see the SIM_LOG_LEVEL cmake option). Log statements above that level are
+ * compiled out entirely, arguments included. Statements at or below it are
+ * printed when 'sim::verbose_enabled' is set at runtime. */
+#define SIM_LOG_LEVEL_NONE 0
+#define SIM_LOG_LEVEL_INFO 1 // Scheduler decisions and tick boundaries
+#define SIM_LOG_LEVEL_DEBUG 2 // Per-elevator state and approvals
+
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL SIM_LOG_LEVEL_DEBUG
+#endif
+
+#if SIM_LOG_LEVEL >= SIM_LOG_LEVEL_INFO
+#define SIM_INFO(...) \
+  do { if (sim::verbose_enabled) { sim::log('I', __VA_ARGS__); } } while (0)
+#else
+#define SIM_INFO(...) do { } while (0)
+#endif
+
+#if SIM_LOG_LEVEL >= SIM_LOG_LEVEL_DEBUG
+#define SIM_DEBUG(...) \
+  do { if (sim::verbose_enabled) { sim::log('D', __VA_ARGS__); } } while (0)
+#else
+#define SIM_DEBUG(...) do { } while (0)
+#endif
+
 namespace sim {
   extern bool verbose_enabled;
 
-  void debug(const char* format, ...);
+  /**
+   * Formats a log line with the provided one-letter tag. Lines are collected
+   * in a buffer owned by the calling thread, and only written out when the
+   * buffer fills up, flush_log() is called, or the thread exits. Use the
+   * SIM_INFO/SIM_DEBUG macros rather than calling this directly.
+   */
+  void log(char tag, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+  /**
+   * Writes out any log lines buffered by the calling thread. Call this before
+   * printing anything else to stdout, to keep output in order.
+   */
+  void flush_log();
 }
 
 #endif /* _sim_logging_h_ */
@@ -0,0 +1,21 @@
+#include "sim/passengers.h"
+
+const uint32_t sim::PassengerStore::NONE;
+
+sim::PassengerStore::PassengerStore()
+  : free_(NONE),
+    size_(0) { }
+
+void sim::PassengerStore::clear() {
+  tick_.clear();
+  source_.clear();
+  dest_.clear();
+  car_.clear();
+  next_.clear();
+  free_ = NONE;
+  size_ = 0;
+}
+
+size_t sim::PassengerStore::bytes() const {
+  return 5 * capacity() * sizeof(uint32_t);
+}
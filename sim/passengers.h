@@ -0,0 +1,142 @@
+#ifndef _sim_passengers_h_
+#define _sim_passengers_h_
+
+#include <stdint.h>
+#include <vector>
+
+#include "sim/types.h"
+
+namespace sim {
+
+  /**
+   * A pool of passengers, stored as a structure of arrays: one flat array per
+   * field, indexed by passenger. Each passenger is 20 bytes, and the fields
+   * which are walked together (the list links, ticks and destinations) are
+   * packed densely rather than interleaved with the ones that aren't.
+   *
+   * Passengers are linked into singly-linked lists by next(), so that a
+   * Scheduler can keep one list per waiting group and one per car and
+   * destination floor, and board or drop off everyone at a stop without
+   * visiting anyone else. Removed passengers go onto a free list and their
+   * slots are reused, so the pool only grows to the peak number of
+   * passengers in the building at once, however many pass through it.
+   *
+   * Ticks are stored in 32 bits. Differences between them stay correct when
+   * they wrap around, as long as no single passenger waits or rides for over
+   * 2^32 ticks.
+   */
+  class PassengerStore {
+   public:
+    // The end of a list, or a passenger who isn't in a car.
+    static const uint32_t NONE = uint32_t(-1);
+
+    PassengerStore();
+
+    /**
+     * Adds a passenger who arrived at 'source' at the provided tick, heading
+     * to 'dest', and returns its index. The passenger isn't in a car, and
+     * isn't linked to anything.
+     */
+    uint32_t add(size_t tick, floor_t source, floor_t dest) {
+      uint32_t passenger = free_;
+      if (passenger != NONE) {
+        free_ = next_[passenger];
+        tick_[passenger] = tick;
+        source_[passenger] = source;
+        dest_[passenger] = dest;
+        car_[passenger] = NONE;
+        next_[passenger] = NONE;
+      } else {
+        passenger = tick_.size();
+        tick_.push_back(tick);
+        source_.push_back(source);
+        dest_.push_back(dest);
+        car_.push_back(NONE);
+        next_.push_back(NONE);
+      }
+      ++size_;
+      return passenger;
+    }
+
+    /**
+     * Returns a passenger's slot to the free list. It must already have been
+     * unlinked from any list it was in.
+     */
+    void remove(uint32_t passenger) {
+      next_[passenger] = free_;
+      free_ = passenger;
+      --size_;
+    }
+
+    /**
+     * Removes every passenger, keeping the memory for reuse.
+     */
+    void clear();
+
+    /**
+     * Returns the number of passengers in the store, and the number of slots
+     * it has room for without growing.
+     */
+    size_t size() const {
+      return size_;
+    }
+    size_t capacity() const {
+      return tick_.capacity();
+    }
+
+    /**
+     * Returns the number of bytes held by the store's arrays.
+     */
+    size_t bytes() const;
+
+    /**
+     * A passenger's tick: when they arrived, and then when they were picked
+     * up once they're in a car. Stored truncated to 32 bits.
+     */
+    uint32_t tick(uint32_t passenger) const {
+      return tick_[passenger];
+    }
+    void set_tick(uint32_t passenger, size_t tick) {
+      tick_[passenger] = tick;
+    }
+
+    /**
+     * A passenger's source and destination floors.
+     */
+    floor_t source(uint32_t passenger) const {
+      return source_[passenger];
+    }
+    floor_t dest(uint32_t passenger) const {
+      return dest_[passenger];
+    }
+
+    /**
+     * The car which a passenger is riding in, or NONE if they're waiting.
+     */
+    uint32_t car(uint32_t passenger) const {
+      return car_[passenger];
+    }
+    void set_car(uint32_t passenger, uint32_t car) {
+      car_[passenger] = car;
+    }
+
+    /**
+     * The next passenger in the same list, or NONE.
+     */
+    uint32_t next(uint32_t passenger) const {
+      return next_[passenger];
+    }
+    void set_next(uint32_t passenger, uint32_t next) {
+      next_[passenger] = next;
+    }
+
+   private:
+    std::vector<uint32_t> tick_, source_, dest_, car_, next_;
+
+    // Head of the list of free slots.
+    uint32_t free_;
+    size_t size_;
+  };
+}
+
+#endif /* _sim_passengers_h_ */
@@ -0,0 +1,158 @@
+#ifndef _sim_profile_h_
+#define _sim_profile_h_
+
+#include <stdint.h>
+#include <chrono>
+
+/* Phase timing. The timer is selected at compile time by defining SIM_PROFILE
+ * (see the SIM_PROFILE cmake option). With it off, the timing macros below
+ * are compiled out entirely, and phase timings always read as zero. */
+#define SIM_PROFILE_NONE 0
+#define SIM_PROFILE_CLOCK 1 // std::chrono::steady_clock, in nanoseconds
+#define SIM_PROFILE_TSC 2 // The CPU's time stamp counter, in cycles
+
+#ifndef SIM_PROFILE
+#define SIM_PROFILE SIM_PROFILE_NONE
+#endif
+
+// The TSC is only available on x86. Elsewhere, fall back to the clock.
+#if SIM_PROFILE == SIM_PROFILE_TSC && !(defined(__x86_64__) || defined(__i386__))
+#undef SIM_PROFILE
+#define SIM_PROFILE SIM_PROFILE_CLOCK
+#endif
+
+#if SIM_PROFILE == SIM_PROFILE_TSC
+#include <x86intrin.h>
+#endif
+
+#if SIM_PROFILE != SIM_PROFILE_NONE
+#define SIM_PROFILE_BEGIN(name) uint64_t name = sim::profile_now()
+#define SIM_PROFILE_END(timings, phase, name) \
+  (timings).add((phase), sim::profile_now() - (name))
+#else
+#define SIM_PROFILE_BEGIN(name) do { } while (0)
+#define SIM_PROFILE_END(timings, phase, name) do { } while (0)
+#endif
+
+namespace sim {
+
+  /**
+   * The parts of Scheduler::tick() which are timed.
+   */
+  enum Phase {
+    // Handing out pickups to elevators, including any BATCH or ROLLOUT work.
+    PHASE_PICKUPS,
+
+    // The selection loops which ask each elevator to approve a pickup and
+    // score it. This is part of PHASE_PICKUPS.
+    PHASE_APPROVALS,
+
+    // Elevator::tick() for every elevator.
+    PHASE_ELEVATORS,
+
+    // Handling each elevator's action, including passing dropoff floors to
+    // elevators which have opened their doors at a pickup.
+    PHASE_DROPOFFS,
+
+    PHASE_COUNT
+  };
+
+  /**
+   * Returns a short name for the provided Phase.
+   */
+  inline const char *string(Phase phase) {
+    switch (phase) {
+      case PHASE_PICKUPS: return "pickups";
+      case PHASE_APPROVALS: return "approvals";
+      case PHASE_ELEVATORS: return "elevators";
+      case PHASE_DROPOFFS: return "dropoffs";
+      case PHASE_COUNT: break;
+    }
+    return "?";
+  }
+
+  /**
+   * Returns the current time in the units of the compiled-in timer, or 0 if
+   * profiling is compiled out.
+   */
+  inline uint64_t profile_now() {
+#if SIM_PROFILE == SIM_PROFILE_TSC
+    return __rdtsc();
+#elif SIM_PROFILE == SIM_PROFILE_CLOCK
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   * Total time and number of timed sections for each Phase. Times are in
+   * the units given by unit().
+   */
+  class PhaseTimings {
+   public:
+    PhaseTimings() {
+      clear();
+    }
+
+    /**
+     * Returns whether timings are compiled in, and the units they're
+     * measured in: "ns", "cycles", or "" if they're compiled out.
+     */
+    static bool enabled() {
+      return SIM_PROFILE != SIM_PROFILE_NONE;
+    }
+    static const char *unit() {
+      return (SIM_PROFILE == SIM_PROFILE_TSC) ? "cycles"
+        : (SIM_PROFILE == SIM_PROFILE_CLOCK) ? "ns" : "";
+    }
+
+    /**
+     * Adds a timed section to a phase. Use SIM_PROFILE_BEGIN/SIM_PROFILE_END
+     * rather than calling this directly, so that it's compiled out along
+     * with the timer.
+     */
+    void add(Phase phase, uint64_t time) {
+      time_[phase] += time;
+      ++count_[phase];
+    }
+
+    /**
+     * Returns the total time spent in a phase, and the number of sections
+     * which were timed.
+     */
+    uint64_t time(Phase phase) const {
+      return time_[phase];
+    }
+    uint64_t count(Phase phase) const {
+      return count_[phase];
+    }
+
+    /**
+     * Adds all of the timings from another PhaseTimings to this one.
+     */
+    void merge(const PhaseTimings &other) {
+      for (int i = 0; i < PHASE_COUNT; ++i) {
+        time_[i] += other.time_[i];
+        count_[i] += other.count_[i];
+      }
+    }
+
+    /**
+     * Sets all timings back to zero.
+     */
+    void clear() {
+      for (int i = 0; i < PHASE_COUNT; ++i) {
+        time_[i] = 0;
+        count_[i] = 0;
+      }
+    }
+
+   private:
+    uint64_t time_[PHASE_COUNT];
+    uint64_t count_[PHASE_COUNT];
+  };
+}
+
+#endif /* _sim_profile_h_ */
@@ -0,0 +1,124 @@
+#ifndef _sim_random_h_
+#define _sim_random_h_
+
+#include <stdint.h>
+
+namespace sim {
+
+  /**
+   * Returns a uniformly distributed value in [0, bound) from a generator's
+   * next() values, without the bias of 'next() % bound'. 'bound' must be
+   * greater than zero.
+   */
+  template <typename Generator>
+  uint64_t bounded(Generator &generator, uint64_t bound) {
+    // Lemire's multiply-shift, rejecting the few values which would skew the
+    // result towards low numbers.
+    unsigned __int128 m = (unsigned __int128)generator.next() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+      uint64_t threshold = -bound % bound;
+      while (low < threshold) {
+        m = (unsigned __int128)generator.next() * bound;
+        low = (uint64_t)m;
+      }
+    }
+    return m >> 64;
+  }
+
+  /**
+   * A small seedable random number generator (SplitMix64). Unlike rand(), each
+   * instance has its own state, so separate simulations may each have their
+   * own generator and produce the same sequence regardless of which thread
+   * they run on.
+   */
+  class Random {
+   public:
+    Random(uint64_t seed = 0) : state_(seed) { }
+
+    /**
+     * Returns the next 64 random bits.
+     */
+    uint64_t next() {
+      uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    /**
+     * Returns a uniformly distributed value in [0, bound), without the bias
+     * of 'next() % bound'. 'bound' must be greater than zero.
+     */
+    uint64_t below(uint64_t bound) {
+      return bounded(*this, bound);
+    }
+
+   private:
+    uint64_t state_;
+  };
+
+  /**
+   * A counter-based random number generator. Value N of a stream is a hash of
+   * the stream's key and N, so it can be computed directly with at(), without
+   * generating the values before it. split() derives independent child
+   * streams, eg one per thread or per tick, so that work may be divided up
+   * any way without changing the values each part sees. Only integer
+   * arithmetic is used, so the values are the same on every platform.
+   */
+  class RandomStream {
+   public:
+    explicit RandomStream(uint64_t key = 0, uint64_t counter = 0)
+      : key_(key), counter_(counter) { }
+
+    /**
+     * Returns the stream with the provided id under this one. Children with
+     * different ids, and the children of different streams, are independent.
+     */
+    RandomStream split(uint64_t id) const {
+      return RandomStream(mix(mix(key_ ^ 0x5851f42d4c957f2dULL) + id));
+    }
+
+    /**
+     * Returns value 'counter' of the stream. These are the same values that
+     * a Random seeded with the stream's key would return, in order.
+     */
+    uint64_t at(uint64_t counter) const {
+      return mix(key_ + (counter + 1) * 0x9e3779b97f4a7c15ULL);
+    }
+
+    /**
+     * Returns the next value of the stream, and moves the counter on.
+     */
+    uint64_t next() {
+      return at(counter_++);
+    }
+
+    /**
+     * Returns a uniformly distributed value in [0, bound), as with
+     * Random::below(). 'bound' must be greater than zero.
+     */
+    uint64_t below(uint64_t bound) {
+      return bounded(*this, bound);
+    }
+
+    /**
+     * Returns the number of values taken with next() so far.
+     */
+    uint64_t counter() const {
+      return counter_;
+    }
+
+   private:
+    // The SplitMix64 finalizer.
+    static uint64_t mix(uint64_t z) {
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    uint64_t key_, counter_;
+  };
+}
+
+#endif /* _sim_random_h_ */
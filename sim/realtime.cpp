@@ -0,0 +1,94 @@
+#include "sim/realtime.h"
+#include "sim/logging.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+namespace {
+  const uint64_t NS_PER_SEC = 1000000000ULL;
+
+  uint64_t now_ns() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NS_PER_SEC + now.tv_nsec;
+  }
+
+  /**
+   * Sleeps until the monotonic clock reaches the provided time. Sleeping to
+   * an absolute time, rather than for a duration, means that time spent
+   * waking up doesn't push the next wakeup back.
+   */
+  void sleep_until_ns(uint64_t time) {
+    timespec until;
+    until.tv_sec = time / NS_PER_SEC;
+    until.tv_nsec = time % NS_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL)
+        == EINTR) {
+      // Interrupted by a signal. Go back to sleep.
+    }
+  }
+}
+
+bool sim::pin_current_thread(size_t core) {
+#ifdef __linux__
+  if (core >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(core, &cpus);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+  return false;
+#endif
+}
+
+sim::RealtimeDriver::RealtimeDriver(Scheduler &scheduler, uint64_t period_ns)
+  : scheduler_(scheduler),
+    period_ns_(period_ns),
+    stop_(false) { }
+
+sim::RealtimeDriver::~RealtimeDriver() {
+}
+
+size_t sim::RealtimeDriver::run(size_t ticks) {
+  uint64_t start = now_ns();
+  size_t run = 0;
+  for (; run < ticks && !stop_.load(std::memory_order_relaxed); ++run) {
+    uint64_t due = start + run * period_ns_;
+    sleep_until_ns(due);
+
+    uint64_t begin = now_ns();
+    size_t tick = scheduler_.tick_count() + 1;
+    scheduler_.tick();
+    uint64_t end = now_ns();
+
+    uint64_t lateness = (begin > due) ? begin - due : 0;
+    durations_.record(end - begin);
+    lateness_.record(lateness);
+    if (end > due + period_ns_) {
+      SIM_INFO("Tick %lu missed its deadline: started %luns late, ran %luns",
+          tick, lateness, end - begin);
+      misses_.push_back(DeadlineMiss(tick, lateness, end - begin));
+    }
+  }
+  return run;
+}
+
+void sim::RealtimeDriver::stop() {
+  stop_.store(true);
+}
+
+const sim::Histogram &sim::RealtimeDriver::tick_durations() const {
+  return durations_;
+}
+
+const sim::Histogram &sim::RealtimeDriver::start_lateness() const {
+  return lateness_;
+}
+
+const std::vector<sim::DeadlineMiss> &sim::RealtimeDriver::misses() const {
+  return misses_;
+}
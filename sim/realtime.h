@@ -0,0 +1,94 @@
+#ifndef _sim_realtime_h_
+#define _sim_realtime_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "sim/histogram.h"
+#include "sim/scheduler.h"
+
+namespace sim {
+
+  /**
+   * Pins the calling thread to the provided CPU core, so that it isn't
+   * migrated between cores. Returns false if it couldn't be pinned, eg if
+   * there's no such core or the platform doesn't support it.
+   */
+  bool pin_current_thread(size_t core);
+
+  /**
+   * A tick which finished after its deadline, from RealtimeDriver.
+   */
+  class DeadlineMiss {
+   public:
+    DeadlineMiss(size_t tick = 0, uint64_t lateness_ns = 0,
+        uint64_t duration_ns = 0)
+      : tick(tick), lateness_ns(lateness_ns), duration_ns(duration_ns) { }
+
+    // The scheduler's tick number, where the first tick is 1.
+    size_t tick;
+
+    // How late the tick started, and how long it took to run.
+    uint64_t lateness_ns, duration_ns;
+  };
+
+  /**
+   * Runs a Scheduler in step with the wall clock, for driving it alongside
+   * real hardware. Tick N is due to start at N periods after run() is
+   * called, on the monotonic clock, and must finish before the next one is
+   * due. The driver sleeps until each tick is due, so the schedule doesn't
+   * drift however long the ticks take. If a tick overruns, the following
+   * ones start late, back to back, until the schedule has caught up.
+   *
+   * Every tick's duration and start lateness are recorded, along with each
+   * tick which missed its deadline. Requests may be fed in from other
+   * threads with Scheduler::set_request_queue().
+   */
+  class RealtimeDriver {
+   public:
+    /**
+     * Creates a driver which runs the provided scheduler's ticks once every
+     * 'period_ns' nanoseconds. The scheduler isn't owned by the driver.
+     */
+    RealtimeDriver(Scheduler &scheduler, uint64_t period_ns);
+    virtual ~RealtimeDriver();
+
+    /**
+     * Runs up to the provided number of ticks on the calling thread, returning
+     * the number which were run. Returns early if stop() is called.
+     */
+    size_t run(size_t ticks);
+
+    /**
+     * Makes run() return once its current tick has finished, and any later
+     * run() return straight away. This may be called from any thread.
+     */
+    void stop();
+
+    /**
+     * Returns how long each tick took to run, in nanoseconds.
+     */
+    const Histogram &tick_durations() const;
+
+    /**
+     * Returns how long after it was due each tick started, in nanoseconds.
+     */
+    const Histogram &start_lateness() const;
+
+    /**
+     * Returns the ticks which finished after the next tick was due, in the
+     * order they ran.
+     */
+    const std::vector<DeadlineMiss> &misses() const;
+
+   private:
+    Scheduler &scheduler_;
+    uint64_t period_ns_;
+    std::atomic<bool> stop_;
+    Histogram durations_, lateness_;
+    std::vector<DeadlineMiss> misses_;
+  };
+}
+
+#endif /* _sim_realtime_h_ */
@@ -0,0 +1,132 @@
+#include "sim/request_queue.h"
+
+#include <cassert>
+#include <vector>
+
+namespace {
+  // Padding which keeps the producer's and consumer's indexes on separate
+  // cache lines, so that they don't bounce between cores on every request.
+  const size_t CACHE_LINE = 64;
+}
+
+/**
+ * A single-producer, single-consumer ring. 'tail' is only written by the
+ * producer and 'head' by the consumer. Each side keeps a cached copy of the
+ * other's index, and only reloads it when the ring looks full or empty.
+ */
+class sim::RequestQueue::Lane {
+ public:
+  Lane()
+    : head(0), cached_tail(0), marked_tail(0), tail(0), cached_head(0),
+      dropped(0) { }
+
+  // Consumer side. 'marked_tail' is the tail as of the last mark().
+  std::atomic<size_t> head;
+  size_t cached_tail;
+  size_t marked_tail;
+  char consumer_pad[CACHE_LINE];
+
+  // Producer side.
+  std::atomic<size_t> tail;
+  size_t cached_head;
+  std::atomic<size_t> dropped;
+  char producer_pad[CACHE_LINE];
+
+  // Shared, and only written before any producer starts.
+  size_t mask;
+  std::vector<std::pair<floor_t, floor_t> > slots;
+  char shared_pad[CACHE_LINE];
+};
+
+bool sim::RequestQueue::Producer::submit(floor_t source, floor_t dest) {
+  Lane &lane = *lane_;
+  size_t tail = lane.tail.load(std::memory_order_relaxed);
+  if (tail - lane.cached_head == lane.slots.size()) {
+    lane.cached_head = lane.head.load(std::memory_order_acquire);
+    if (tail - lane.cached_head == lane.slots.size()) {
+      // Full. Count it without a read-modify-write, since we're the only
+      // writer.
+      lane.dropped.store(lane.dropped.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+      return false;
+    }
+  }
+  lane.slots[tail & lane.mask] = std::make_pair(source, dest);
+  lane.tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+sim::RequestQueue::RequestQueue(size_t producers, size_t capacity/*=1024*/)
+  : producers_(producers),
+    lanes_(new Lane[producers]),
+    next_lane_(0) {
+  assert(producers > 0);
+  size_t size = 1;
+  while (size < capacity) {
+    size *= 2;
+  }
+  for (size_t i = 0; i < producers; ++i) {
+    lanes_[i].mask = size - 1;
+    lanes_[i].slots.resize(size);
+  }
+}
+
+sim::RequestQueue::~RequestQueue() {
+}
+
+sim::RequestQueue::Producer sim::RequestQueue::producer(size_t index) {
+  assert(index < producers_);
+  return Producer(&lanes_[index]);
+}
+
+size_t sim::RequestQueue::drain(Request *out, size_t max) {
+  return drain_lanes(out, max, false);
+}
+
+void sim::RequestQueue::mark() {
+  for (size_t i = 0; i < producers_; ++i) {
+    Lane &lane = lanes_[i];
+    lane.cached_tail = lane.tail.load(std::memory_order_acquire);
+    lane.marked_tail = lane.cached_tail;
+  }
+}
+
+size_t sim::RequestQueue::drain_marked(Request *out, size_t max) {
+  return drain_lanes(out, max, true);
+}
+
+size_t sim::RequestQueue::drain_lanes(Request *out, size_t max,
+    bool marked) {
+  size_t count = 0;
+  for (size_t visited = 0; visited < producers_ && count < max; ++visited) {
+    Lane &lane = lanes_[next_lane_];
+    next_lane_ = (next_lane_ + 1) % producers_;
+    size_t head = lane.head.load(std::memory_order_relaxed);
+    if (!marked && lane.cached_tail - head < max - count) {
+      // There may be more than we last saw.
+      lane.cached_tail = lane.tail.load(std::memory_order_acquire);
+    }
+    size_t end = marked ? lane.marked_tail : lane.cached_tail;
+    if (end - head > lane.slots.size()) {
+      // Already drained past the mark by drain().
+      end = head;
+    }
+    if (end - head > max - count) {
+      end = head + (max - count);
+    }
+    for (; head != end; ++head) {
+      const std::pair<floor_t, floor_t> &slot = lane.slots[head & lane.mask];
+      out[count++] = Request(0, slot.first, slot.second);
+    }
+    lane.head.store(head, std::memory_order_release);
+  }
+  return count;
+}
+
+size_t sim::RequestQueue::dropped() const {
+  size_t dropped = 0;
+  for (size_t i = 0; i < producers_; ++i) {
+    dropped += lanes_[i].dropped.load(std::memory_order_relaxed);
+  }
+  return dropped;
+}
@@ -0,0 +1,105 @@
+#ifndef _sim_request_queue_h_
+#define _sim_request_queue_h_
+
+#include <atomic>
+#include <memory>
+
+#include "sim/types.h"
+
+namespace sim {
+
+  /**
+   * A queue which takes requests from many producer threads and hands them to
+   * a single consumer, normally a Scheduler which drains it at the start of
+   * each tick (see Scheduler::set_request_queue()).
+   *
+   * Each producer gets its own single-producer ring, or lane, so producers
+   * never contend with each other. Submitting is wait-free: a few loads and
+   * stores with no locks, retries or system calls. If a lane is full, the
+   * request is dropped and counted rather than waiting for the consumer.
+   */
+  class RequestQueue {
+   private:
+    class Lane;
+
+   public:
+    /**
+     * A handle for submitting requests to one lane. Each Producer must only
+     * be used by one thread at a time, but may be copied and handed off.
+     */
+    class Producer {
+     public:
+      Producer() : lane_(NULL) { }
+
+      /**
+       * Queues a request from 'source' to 'dest', returning false if the
+       * lane was full and it was dropped. The request isn't checked until
+       * it's drained, so invalid requests are accepted here.
+       */
+      bool submit(floor_t source, floor_t dest);
+
+     private:
+      friend class RequestQueue;
+      explicit Producer(Lane *lane) : lane_(lane) { }
+
+      Lane *lane_;
+    };
+
+    /**
+     * Creates a queue with the provided number of lanes, each with room for
+     * at least 'capacity' requests. Capacities are rounded up to a power of
+     * two.
+     */
+    RequestQueue(size_t producers, size_t capacity = 1024);
+    virtual ~RequestQueue();
+
+    /**
+     * Returns the handle for the provided lane, which must be less than the
+     * number of producers the queue was created with.
+     */
+    Producer producer(size_t index);
+
+    /**
+     * Moves up to 'max' queued requests into 'out', returning the number
+     * moved. Returns 0 if nothing is queued right now. Requests from one
+     * lane come out in the order they were submitted, and lanes are visited
+     * in turn. The requests' ticks are left at 0. This must only be called
+     * from one thread at a time.
+     */
+    size_t drain(Request *out, size_t max);
+
+    /**
+     * Notes how far each lane has been filled, for drain_marked(). Like
+     * drain(), this must only be called from the consumer's thread.
+     */
+    void mark();
+
+    /**
+     * As drain(), but only moves requests which were queued by the last
+     * mark(), and returns 0 once they've all been moved. Producers which
+     * keep submitting can't hold up a consumer which drains this way.
+     */
+    size_t drain_marked(Request *out, size_t max);
+
+    /**
+     * Returns the number of requests which were dropped because their lane
+     * was full.
+     */
+    size_t dropped() const;
+
+   private:
+    RequestQueue(const RequestQueue&);
+    RequestQueue &operator=(const RequestQueue&);
+
+    size_t drain_lanes(Request *out, size_t max, bool marked);
+
+    size_t producers_;
+    std::unique_ptr<Lane[]> lanes_;
+
+    // The lane that the next drain() starts from, so that a busy lane can't
+    // starve the others.
+    size_t next_lane_;
+  };
+}
+
+#endif /* _sim_request_queue_h_ */
@@ -1,8 +1,76 @@
 #include "sim/scheduler.h"
 #include "sim/elevator.h"
+#include "sim/hash.h"
 #include "sim/logging.h"
+#include "sim/request_queue.h"
+#include "sim/trace.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+
+namespace {
+  // Minimum number of elevators handed to a thread at a time by a parallel
+  // tick. Elevator ticks are cheap, so smaller chunks would mostly add
+  // contention.
+  const size_t PARALLEL_GRAIN = 32;
+
+  // Default time allowed for a BATCH assignment each tick, in microseconds.
+  const size_t DEFAULT_BATCH_BUDGET = 1000;
+
+  // Default ticks simulated ahead for each ROLLOUT candidate, and time
+  // allowed for the rollouts in each tick, in microseconds.
+  const size_t DEFAULT_ROLLOUT_HORIZON = 32;
+  const size_t DEFAULT_ROLLOUT_BUDGET = 1000;
+
+  // Returned by Scheduler::rollout() when it runs out of time.
+  const uint64_t NO_SCORE = uint64_t(-1);
+
+  // Requests taken from a RequestQueue at a time.
+  const size_t QUEUE_DRAIN_CHUNK = 256;
+
+  // Returned by quiet_ticks() when nothing will happen without new requests.
+  const size_t NO_EVENT = size_t(-1);
+
+  /**
+   * Returns the number of bytes needed for all of a Scheduler's FloorSets:
+   * one per elevator, two per floor for the request groups, and the two
+   * pickup indexes.
+   */
+  size_t arena_size(sim::floor_t floors, size_t elevators) {
+    size_t sets = elevators + 2 * floors + 2;
+    return sets * ((floors + 63) / 64) * sizeof(uint64_t);
+  }
+
+  // End of a list of passengers.
+  const uint32_t NO_REQUEST = sim::PassengerStore::NONE;
+
+  /* Zobrist keys for the parts of the pickup group at 'source' going in
+   * 'direction'. An empty group contributes nothing to the hash. */
+  inline uint64_t group_id(sim::floor_t source, sim::Direction direction) {
+    return (uint64_t(source) << 1) | (direction == sim::Direction::DOWN);
+  }
+
+  inline uint64_t dest_key(sim::floor_t source, sim::Direction direction,
+      sim::floor_t dest) {
+    return sim::hash_key(sim::HASH_GROUP_DEST,
+        (group_id(source, direction) << 32) | dest);
+  }
+
+  inline uint64_t accepted_key(sim::floor_t source,
+      sim::Direction direction) {
+    return sim::hash_key(sim::HASH_GROUP_ACCEPTED, group_id(source, direction));
+  }
+
+  inline uint64_t count_key(sim::floor_t source, sim::Direction direction,
+      uint32_t count) {
+    if (count == 0) {
+      return 0;
+    }
+    return sim::hash_key(sim::HASH_GROUP_COUNT,
+        (group_id(source, direction) << 32) | count);
+  }
+}
 
 namespace sim {
   /**
@@ -11,7 +79,9 @@ namespace sim {
    */
   class RequestGroup {
    public:
-    RequestGroup() : accepted(false) { }
+    RequestGroup(floor_t floors = 0, Arena *arena = NULL)
+      : dests(floors, arena), accepted(false), waiting(NO_REQUEST),
+        last(NO_REQUEST), count(0) { }
 
     // Set of destination/dropoff floors which will be passed to the elevator
     // when it arrives at the source floor.
@@ -19,21 +89,200 @@ namespace sim {
 
     // Whether the source/pickup has been accepted by an elevator.
     bool accepted;
+
+    // List of the passengers for 'dests', in the order they arrived, its
+    // last entry, and its length. Without passenger mode, there's one
+    // passenger per floor in 'dests'.
+    uint32_t waiting, last, count;
   };
 }
 
+const char *sim::string(Dispatch dispatch) {
+  switch (dispatch) {
+    case FEWEST_REQUESTS: return "fewest";
+    case LOWEST_ETA: return "eta";
+    case BATCH: return "batch";
+    case ROLLOUT: return "rollout";
+    case CUSTOM_POLICY: return "custom";
+  }
+  return "?";
+}
+
+bool sim::parse_dispatch(const char *name, Dispatch &dispatch) {
+  static const Dispatch ALL[] = {FEWEST_REQUESTS, LOWEST_ETA, BATCH, ROLLOUT};
+  for (Dispatch candidate : ALL) {
+    if (strcmp(name, string(candidate)) == 0) {
+      dispatch = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
 sim::Scheduler::Scheduler(floor_t floors, size_t elevators)
-  : elevators(elevators, Elevator()),
-    pending_up_requests(floors, RequestGroup()),
-    pending_down_requests(floors, RequestGroup()),
-    tick_(1) {
+  : arena_(arena_size(floors, elevators)),
+    tick_(1),
+    groups_hash_(0),
+    hash_check_(false),
+    hash_mismatch_tick_(0),
+    up_pickups_(0, &arena_),
+    down_pickups_(0, &arena_),
+    fleet_(elevators),
+    vectorized_(false),
+    dispatch_(FEWEST_REQUESTS),
+    select_(&select_car<FewestRequestsPolicy, Elevator>),
+    batch_budget_(DEFAULT_BATCH_BUDGET),
+    rollout_horizon_(DEFAULT_ROLLOUT_HORIZON),
+    rollout_budget_(DEFAULT_ROLLOUT_BUDGET),
+    actions_(elevators),
+    riders_(elevators * floors, NO_REQUEST),
+    load_(elevators, 0),
+    passenger_mode_(false),
+    capacity_(0),
+    trace_(NULL),
+    arrivals_(NULL),
+    queue_(NULL) {
   assert(floors > 0);
   assert(elevators > 0);
+  build_state(floors, elevators);
 }
 
 sim::Scheduler::~Scheduler() {
 }
 
+void sim::Scheduler::reset() {
+  build_state(pending_up_requests.size(), elevators.size());
+  tick_ = 1;
+  stats_ = SchedulerStats();
+  groups_hash_ = 0;
+  hash_mismatch_tick_ = 0;
+  if (vectorized_) {
+    for (size_t i = 0; i < elevators.size(); ++i) {
+      fleet_.update(i, elevators[i]);
+    }
+  }
+  passengers_.clear();
+  riders_.assign(riders_.size(), NO_REQUEST);
+  load_.assign(elevators.size(), 0);
+  latency_.wait.clear();
+  latency_.travel.clear();
+  phases_.clear();
+  held_.clear();
+  while (!scheduled_.empty()) {
+    scheduled_.pop();
+  }
+}
+
+void sim::Scheduler::build_state(floor_t floors, size_t elevator_count) {
+  /* Rewind the arena and recreate everything that lives in it, in the same
+   * order each time. The vectors keep their capacity, so this doesn't
+   * allocate after the first time. */
+  arena_.reset();
+  up_pickups_ = FloorSet(floors, &arena_);
+  down_pickups_ = FloorSet(floors, &arena_);
+  elevators.clear();
+  elevators.reserve(elevator_count);
+  for (size_t i = 0; i < elevator_count; ++i) {
+    elevators.push_back(Elevator(0, floors, &arena_));
+  }
+  pending_up_requests.clear();
+  pending_down_requests.clear();
+  pending_up_requests.reserve(floors);
+  pending_down_requests.reserve(floors);
+  for (floor_t floor = 0; floor < floors; ++floor) {
+    pending_up_requests.push_back(RequestGroup(floors, &arena_));
+    pending_down_requests.push_back(RequestGroup(floors, &arena_));
+  }
+}
+
+void sim::Scheduler::save(Snapshot &snapshot) const {
+  floor_t floors = pending_up_requests.size();
+  snapshot.floors_ = floors;
+  arena_.save(snapshot.arena_);
+  snapshot.elevators_.resize(elevators.size());
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    snapshot.elevators_[i] = elevators[i].state();
+  }
+  snapshot.groups_.resize(2 * floors);
+  for (floor_t floor = 0; floor < 2 * floors; ++floor) {
+    const RequestGroup &group = (floor < floors)
+      ? pending_up_requests[floor] : pending_down_requests[floor - floors];
+    Snapshot::Group &saved = snapshot.groups_[floor];
+    saved.accepted = group.accepted;
+    saved.waiting = group.waiting;
+    saved.last = group.last;
+    saved.count = group.count;
+  }
+  snapshot.groups_hash_ = groups_hash_;
+  snapshot.tick_ = tick_;
+  snapshot.stats_ = stats_;
+  snapshot.passengers_ = passengers_;
+  snapshot.riders_ = riders_;
+  snapshot.load_ = load_;
+  snapshot.latency_ = latency_;
+  snapshot.held_ = held_;
+  snapshot.scheduled_ = scheduled_;
+}
+
+bool sim::Scheduler::restore(const Snapshot &snapshot) {
+  floor_t floors = pending_up_requests.size();
+  if (snapshot.floors_ != floors
+      || snapshot.elevators_.size() != elevators.size()
+      || !arena_.restore(snapshot.arena_)) {
+    return false;
+  }
+  /* The arena now holds the saved FloorSet words, since everything in it was
+   * allocated in the same order. Bring the rest of each object up to date. */
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    elevators[i].restore(snapshot.elevators_[i]);
+    if (vectorized_) {
+      fleet_.update(i, elevators[i]);
+    }
+  }
+  for (floor_t floor = 0; floor < 2 * floors; ++floor) {
+    RequestGroup &group = (floor < floors)
+      ? pending_up_requests[floor] : pending_down_requests[floor - floors];
+    const Snapshot::Group &saved = snapshot.groups_[floor];
+    group.dests.recount();
+    group.accepted = saved.accepted;
+    group.waiting = saved.waiting;
+    group.last = saved.last;
+    group.count = saved.count;
+  }
+  up_pickups_.recount();
+  down_pickups_.recount();
+  groups_hash_ = snapshot.groups_hash_;
+  tick_ = snapshot.tick_;
+  stats_ = snapshot.stats_;
+  passengers_ = snapshot.passengers_;
+  riders_ = snapshot.riders_;
+  load_ = snapshot.load_;
+  latency_ = snapshot.latency_;
+  held_ = snapshot.held_;
+  scheduled_ = snapshot.scheduled_;
+  return true;
+}
+
+std::unique_ptr<sim::Scheduler> sim::Scheduler::fork() const {
+  std::unique_ptr<Scheduler> copy(
+      new Scheduler(pending_up_requests.size(), elevators.size()));
+  copy->dispatch_ = dispatch_;
+  copy->select_ = select_;
+  copy->batch_budget_ = batch_budget_;
+  copy->rollout_horizon_ = rollout_horizon_;
+  copy->rollout_budget_ = rollout_budget_;
+  copy->passenger_mode_ = passenger_mode_;
+  copy->capacity_ = capacity_;
+  copy->set_vectorized(vectorized_);
+  if (pool_) {
+    copy->set_threads(pool_->size());
+  }
+  Snapshot snapshot;
+  save(snapshot);
+  copy->restore(snapshot);
+  return copy;
+}
+
 bool sim::Scheduler::insert_request(floor_t source, floor_t dest) {
   if (source >= pending_up_requests.size()
       || dest >= pending_up_requests.size()) {
@@ -43,46 +292,404 @@ bool sim::Scheduler::insert_request(floor_t source, floor_t dest) {
   }
 
   // Save the request, to be passed to an elevator within tick().
+  RequestGroup *group;
+  FloorSet *pickup_floors;
+  Direction direction;
   if (source > dest) {
     // Destination is below source. Down request.
-    return pending_down_requests[source].dests.insert(dest).second;
+    group = &pending_down_requests[source];
+    pickup_floors = &down_pickups_;
+    direction = Direction::DOWN;
   } else if (source < dest) {
     // Destination is above source. Up request.
-    return pending_up_requests[source].dests.insert(dest).second;
+    group = &pending_up_requests[source];
+    pickup_floors = &up_pickups_;
+    direction = Direction::UP;
   } else {
     /* Invalid input: source equals destination. We could also treat this as
      * valid, where the elevator just arrives and performs a single door
      * operation, but let's keep things relatively simple for now. */
     return false;
   }
+
+  bool new_dest = group->dests.insert(dest);
+  if (!new_dest && !passenger_mode_) {
+    // Identical request already queued.
+    return false;
+  }
+  // Passengers join the back of the waiting list, so that they board in the
+  // order they arrived.
+  uint32_t passenger = passengers_.add(tick_, source, dest);
+  if (group->waiting == NO_REQUEST) {
+    group->waiting = passenger;
+  } else {
+    passengers_.set_next(group->last, passenger);
+  }
+  group->last = passenger;
+  groups_hash_ ^= count_key(source, direction, group->count)
+    ^ count_key(source, direction, group->count + 1);
+  ++group->count;
+  ++stats_.waiting;
+  if (trace_ != NULL) {
+    trace_->record(TRACE_REQUEST, tick_, 0, source, dest);
+  }
+  if (!new_dest) {
+    // Another passenger for a floor which is already requested.
+    return true;
+  }
+  groups_hash_ ^= dest_key(source, direction, dest);
+  ++stats_.pending_dests;
+  if (group->dests.size() == 1 && !group->accepted) {
+    // Group was empty until now, so it's a new pickup.
+    ++stats_.pending_groups;
+    pickup_floors->insert(source);
+  }
+  return true;
+}
+
+bool sim::Scheduler::schedule_request(size_t tick, floor_t source,
+    floor_t dest) {
+  if (source >= pending_up_requests.size()
+      || dest >= pending_up_requests.size()
+      || source == dest) {
+    // Invalid input, same as insert_request()
+    return false;
+  }
+  scheduled_.push(Request(std::max(tick, tick_), source, dest));
+  return true;
 }
 
 void sim::Scheduler::tick() {
-  debug("--- Start of tick %lu", tick_);
+  SIM_INFO("--- Start of tick %lu", tick_);
 
-  // Phase 1: Pass requests to any Elevator which will accept them.
-  debug("Upward pickups:");
-  add_any_pickup_requests(elevators, pending_up_requests, Direction::UP);
-  debug("Downward pickups:");
-  add_any_pickup_requests(elevators, pending_down_requests, Direction::DOWN);
+  // Insert anything which other threads submitted before this tick started.
+  // Anything submitted while draining waits for the next tick, so that busy
+  // producers can't hold the tick up. A partial chunk means that everything
+  // up to the mark has been drained.
+  if (queue_ != NULL) {
+    queue_->mark();
+    size_t count;
+    do {
+      count = queue_->drain_marked(queue_buffer_.data(),
+          queue_buffer_.size());
+      for (size_t i = 0; i < count; ++i) {
+        insert_request(queue_buffer_[i].source, queue_buffer_[i].dest);
+      }
+    } while (count == queue_buffer_.size());
+  }
+
+  // Insert any scheduled requests which have arrived.
+  while (!scheduled_.empty() && scheduled_.top().tick <= tick_) {
+    const Request &request = scheduled_.top();
+    insert_request(request.source, request.dest);
+    scheduled_.pop();
+  }
+
+  // Phase 1: Pass requests to any Elevator which will accept them. A batch
+  // assignment goes first, with any pickups it leaves assigned greedily.
+  SIM_PROFILE_BEGIN(pickups_start);
+  if (dispatch_ == BATCH) {
+    assign_pickups_batch();
+  } else if (dispatch_ == ROLLOUT) {
+    rollout_deadline_ = AssignmentSolver::clock::now()
+      + std::chrono::microseconds(rollout_budget_);
+  }
+  SIM_DEBUG("Upward pickups:");
+  add_any_pickup_requests(
+      elevators, pending_up_requests, up_pickups_, Direction::UP);
+  SIM_DEBUG("Downward pickups:");
+  add_any_pickup_requests(
+      elevators, pending_down_requests, down_pickups_, Direction::DOWN);
+  SIM_PROFILE_END(phases_, PHASE_PICKUPS, pickups_start);
 
+  // Pickups held back before this tick's elevators move may be released once
+  // they have.
+  size_t held = held_.size();
+  // Phase 2: Run elevator ticks. Each only touches its own Elevator, so they
+  // may run in parallel, and the resulting actions are handled in order
+  // below. Each phase is timed once for all of the elevators.
+  SIM_PROFILE_BEGIN(elevators_start);
+  if (pool_) {
+    pool_->parallel_for(elevators.size(), [this](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        actions_[i] = elevators[i].tick();
+      }
+    }, PARALLEL_GRAIN);
+  } else {
+    for (size_t i = 0; i < elevators.size(); ++i) {
+      SIM_DEBUG("Elevator %lu pre-tick: floor[%lu] direction[%s]", i,
+          elevators[i].floor(), string(elevators[i].direction()));
+      actions_[i] = elevators[i].tick();
+    }
+  }
+  SIM_PROFILE_END(phases_, PHASE_ELEVATORS, elevators_start);
+  SIM_PROFILE_BEGIN(dropoffs_start);
   for (size_t i = 0; i < elevators.size(); ++i) {
-    debug("Elevator %lu:", i);
-    Elevator &elevator = elevators[i];
+    SIM_DEBUG("Elevator %lu:", i);
+    finish_elevator_tick(i, actions_[i]);
+  }
+  SIM_PROFILE_END(phases_, PHASE_DROPOFFS, dropoffs_start);
+  if (held != 0) {
+    release_held_pickups(held);
+  }
+  if (trace_ != NULL || hash_check_) {
+    record_state_hash(tick_);
+  }
+
+  SIM_INFO("--- End of tick %lu", tick_);
+  ++tick_;
+}
+
+void sim::Scheduler::run_until(size_t ticks) {
+  while (tick_count() < ticks) {
+    size_t quiet = quiet_ticks();
+    if (quiet == 0) {
+      tick();
+    } else {
+      skip_ticks(std::min(quiet, ticks - tick_count()));
+    }
+  }
+}
+
+size_t sim::Scheduler::advance_to_next_event() {
+  size_t quiet = quiet_ticks();
+  if (quiet == NO_EVENT) {
+    return 0;
+  }
+  skip_ticks(quiet);
+  tick();
+  return quiet + 1;
+}
+
+size_t sim::Scheduler::tick_count() const {
+  return tick_ - 1;
+}
+
+bool sim::Scheduler::idle() const {
+  // Check local request queues, then elevators for idle status
+  return stats_.pending_dests == 0 && stats_.elevator_requests == 0
+    && scheduled_.empty();
+}
 
-    // Phase 2: Run elevator ticks.
-    debug("  Pre-tick: floor[%lu] direction[%s]",
-        elevator.floor(), string(elevator.direction()));
-    Action action = elevator.tick();
-    debug("  Post-tick: floor[%lu] direction[%s] action[%s]",
-        elevator.floor(), string(elevator.direction()), string(action));
+const sim::SchedulerStats &sim::Scheduler::stats() const {
+  return stats_;
+}
+
+const sim::LatencyStats &sim::Scheduler::latency() const {
+  return latency_;
+}
+
+const sim::PhaseTimings &sim::Scheduler::phase_timings() const {
+  return phases_;
+}
+
+uint64_t sim::Scheduler::state_hash() const {
+  uint64_t hash = groups_hash_;
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    hash ^= hash_part(HASH_ELEVATOR, i, elevators[i].hash());
+  }
+  return hash;
+}
+
+uint64_t sim::Scheduler::compute_state_hash() const {
+  uint64_t hash = 0;
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    hash ^= hash_part(HASH_ELEVATOR, i, elevators[i].compute_hash());
+  }
+  for (floor_t floor = 0; floor < pending_up_requests.size(); ++floor) {
+    const Direction DIRECTIONS[] = {Direction::UP, Direction::DOWN};
+    for (Direction direction : DIRECTIONS) {
+      const RequestGroup &group = (direction == Direction::UP)
+        ? pending_up_requests[floor] : pending_down_requests[floor];
+      for (floor_t dest : group.dests) {
+        hash ^= dest_key(floor, direction, dest);
+      }
+      if (group.accepted) {
+        hash ^= accepted_key(floor, direction);
+      }
+      hash ^= count_key(floor, direction, group.count);
+    }
+  }
+  return hash;
+}
+
+void sim::Scheduler::set_hash_check(bool enabled) {
+  hash_check_ = enabled;
+}
+
+size_t sim::Scheduler::hash_mismatch_tick() const {
+  return hash_mismatch_tick_;
+}
+
+void sim::Scheduler::set_threads(size_t threads) {
+  if (threads == 1) {
+    pool_.reset();
+  } else {
+    pool_.reset(new ThreadPool(threads));
+  }
+}
+
+void sim::Scheduler::set_trace(TraceWriter *trace) {
+  trace_ = trace;
+}
+
+void sim::Scheduler::set_arrivals(std::vector<Arrival> *arrivals) {
+  arrivals_ = arrivals;
+}
+
+void sim::Scheduler::set_request_queue(RequestQueue *queue) {
+  queue_ = queue;
+  queue_buffer_.resize(QUEUE_DRAIN_CHUNK);
+}
+
+void sim::Scheduler::set_passengers(bool enabled, size_t capacity) {
+  passenger_mode_ = enabled;
+  capacity_ = enabled ? capacity : 0;
+}
+
+const sim::PassengerStore &sim::Scheduler::passengers() const {
+  return passengers_;
+}
+
+size_t sim::Scheduler::load(size_t elevator) const {
+  return load_[elevator];
+}
+
+void sim::Scheduler::set_dispatch(Dispatch dispatch) {
+  switch (dispatch) {
+    case FEWEST_REQUESTS:
+      select_ = &select_car<FewestRequestsPolicy, Elevator>;
+      break;
+    case LOWEST_ETA:
+    case BATCH:
+    case ROLLOUT:
+      // BATCH and ROLLOUT fall back to assigning pickups by ETA.
+      select_ = &select_car<LowestEtaPolicy, Elevator>;
+      break;
+    case CUSTOM_POLICY:
+      // Only set via set_dispatch_policy(), which provides the policy.
+      return;
+  }
+  dispatch_ = dispatch;
+}
+
+void sim::Scheduler::set_batch_budget(size_t microseconds) {
+  batch_budget_ = microseconds;
+}
 
-    if (action != Action::DOOR_OPEN) {
-      // No additional work; Phase 3 not applicable.
+void sim::Scheduler::set_rollout(size_t horizon, size_t microseconds) {
+  rollout_horizon_ = horizon;
+  rollout_budget_ = microseconds;
+}
+
+void sim::Scheduler::set_vectorized(bool enabled) {
+  vectorized_ = enabled;
+  if (enabled) {
+    // Catch the fleet up with any changes made while it was disabled.
+    for (size_t i = 0; i < elevators.size(); ++i) {
+      fleet_.update(i, elevators[i]);
+    }
+  }
+}
+
+size_t sim::Scheduler::quiet_ticks() const {
+  /* Count the ticks until the next time something other than elevator travel
+   * could happen. While elevators are only travelling, their directions don't
+   * change. An elevator travelling in its direction() is only moving further
+   * past any pickup it declines now, so it stays declined. One travelling
+   * against it, such as an UP elevator on its way down to its lowest stop,
+   * approves pickups in its direction() once it reaches their floors, so
+   * the skip stops short of those. */
+  if (!held_.empty() || queue_ != NULL) {
+    // Held pickups are released at the end of the next tick, and requests
+    // may be submitted to the queue at any time.
+    return 0;
+  }
+  size_t quiet = NO_EVENT;
+  if (!scheduled_.empty()) {
+    quiet = scheduled_.top().tick - tick_;
+  }
+  for (const Elevator &elevator : elevators) {
+    if (elevator.request_count() != 0) {
+      quiet = std::min(quiet, elevator.distance_to_next_request());
+    }
+  }
+  if (quiet == 0 || stats_.pending_groups == 0) {
+    return quiet;
+  }
+
+  // Check whether any held pickups would be taken right away.
+  for (floor_t floor : up_pickups_) {
+    for (const Elevator &elevator : elevators) {
+      if (elevator.in_path(floor, Direction::UP)) {
+        return 0;
+      }
+    }
+  }
+  for (floor_t floor : down_pickups_) {
+    for (const Elevator &elevator : elevators) {
+      if (elevator.in_path(floor, Direction::DOWN)) {
+        return 0;
+      }
+    }
+  }
+
+  // Stop when an elevator travelling against its direction() reaches the
+  // nearest pickup that it will approve.
+  for (const Elevator &elevator : elevators) {
+    Direction direction = elevator.direction();
+    Direction travel = elevator.travel_direction();
+    floor_t floor = elevator.floor();
+    if (direction == Direction::UP && travel == Direction::DOWN) {
+      floor_t pickup = up_pickups_.previous(floor);
+      if (pickup != up_pickups_.end_floor()) {
+        quiet = std::min<size_t>(quiet, floor - pickup);
+      }
+    } else if (direction == Direction::DOWN && travel == Direction::UP) {
+      floor_t pickup = down_pickups_.next(floor);
+      if (pickup != down_pickups_.end_floor()) {
+        quiet = std::min<size_t>(quiet, pickup - floor);
+      }
+    }
+  }
+  return quiet;
+}
+
+void sim::Scheduler::skip_ticks(size_t ticks) {
+  SIM_INFO("--- Skipping ticks %lu to %lu", tick_, tick_ + ticks - 1);
+  if (trace_ != NULL) {
+    trace_->record(TRACE_SKIP, tick_, 0, ticks, 0);
+  }
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    Elevator &elevator = elevators[i];
+    if (elevator.request_count() == 0) {
       continue;
     }
+    elevator.skip_floors(ticks);
+    if (vectorized_) {
+      fleet_.update(i, elevator);
+    }
+  }
+  if (trace_ != NULL || hash_check_) {
+    record_state_hash(tick_ + ticks - 1);
+  }
+  tick_ += ticks;
+}
 
-    debug("  Add dropoff requests for direction %s",
+void sim::Scheduler::finish_elevator_tick(size_t index, Action action) {
+  Elevator &elevator = elevators[index];
+  SIM_DEBUG("  Post-tick: floor[%lu] direction[%s] action[%s]",
+      elevator.floor(), string(elevator.direction()), string(action));
+  if (trace_ != NULL && action != Action::IDLE) {
+    trace_->record(TRACE_ACTION, tick_, index, elevator.floor(), action);
+  }
+
+  if (action == Action::DOOR_OPEN) {
+    // The elevator served the request at this floor.
+    --stats_.elevator_requests;
+    drop_off_riders(index, elevator.floor());
+
+    SIM_DEBUG("  Add dropoff requests for direction %s",
         string(elevator.direction()));
     /* Phase 3: For any elevators that performed a DOOR_OPEN action to serve an
      * entry request, populate them with any matching exit request(s) in the
@@ -94,109 +701,464 @@ void sim::Scheduler::tick() {
     switch (elevator.direction()) {
       case Direction::UP:
         add_dropoff_requests(
-          elevator, pending_up_requests[cur_floor], Direction::UP);
+          index, pending_up_requests[cur_floor], Direction::UP);
         break;
       case Direction::DOWN:
         add_dropoff_requests(
-          elevator, pending_down_requests[cur_floor], Direction::DOWN);
+          index, pending_down_requests[cur_floor], Direction::DOWN);
         break;
       case Direction::EITHER:
         // Arbitrarily pick the direction with the most floor requests
         if (pending_up_requests[cur_floor].dests.size()
             >= pending_down_requests[cur_floor].dests.size()) {
           add_dropoff_requests(
-            elevator, pending_up_requests[cur_floor], Direction::UP);
+            index, pending_up_requests[cur_floor], Direction::UP);
         } else {
           add_dropoff_requests(
-            elevator, pending_down_requests[cur_floor], Direction::DOWN);
+            index, pending_down_requests[cur_floor], Direction::DOWN);
         }
         break;
     }
   }
 
-  debug("--- End of tick %lu", tick_);
-  ++tick_;
+  if (vectorized_) {
+    fleet_.update(index, elevator);
+  }
 }
 
-bool sim::Scheduler::idle() const {
-  // Check local request queues
-  for (const RequestGroup &group : pending_up_requests) {
-    if (!group.dests.empty()) {
-      return false;
+void sim::Scheduler::add_any_pickup_requests(std::vector<Elevator> &elevators,
+    std::vector<RequestGroup> &request_groups, FloorSet &pickup_floors,
+    Direction direction) {
+  /* Only visit floors with requests which haven't been accepted yet. Empty
+   * groups and groups already accepted by an elevator aren't in the index.
+   * The current floor may be erased from the index as we go. */
+  for (floor_t pickup_floor = pickup_floors.next(0);
+       pickup_floor != pickup_floors.end_floor();
+       pickup_floor = pickup_floors.next(pickup_floor + 1)) {
+    RequestGroup &pickup_group = request_groups[pickup_floor];
+
+    /* Find the 'best' elevator to take this pickup request, among the elevators
+     * who are willing to take it. By default, we arbitrarily define 'best' as
+     * 'has fewest pending requests', but the dispatch policy decides. */
+    int best_index;
+    SIM_PROFILE_BEGIN(approvals_start);
+    if (vectorized_ && dispatch_ == FEWEST_REQUESTS) {
+      best_index = fleet_.select(pickup_floor, direction);
+    } else if (dispatch_ == ROLLOUT) {
+      best_index = select_rollout(pickup_floor, direction);
+    } else {
+      best_index = select_(elevators, pickup_floor, direction);
+    }
+    SIM_PROFILE_END(phases_, PHASE_APPROVALS, approvals_start);
+    if (best_index >= 0) {
+      assign_pickup(best_index, pickup_group, pickup_floors, pickup_floor,
+          direction);
     }
   }
-  for (const RequestGroup &group : pending_down_requests) {
-    if (!group.dests.empty()) {
-      return false;
+}
+
+void sim::Scheduler::assign_pickup(size_t index, RequestGroup &pickup_group,
+    FloorSet &pickup_floors, floor_t pickup_floor, Direction direction) {
+  SIM_INFO("  -> Pickup inserted into elevator %lu", index);
+  // Insert the request into the chosen elevator, then mark the RequestGroup
+  // as being accepted.
+  Elevator &elevator = elevators[index];
+  size_t request_count = elevator.request_count();
+  elevator.insert_request(pickup_floor, direction);
+  if (trace_ != NULL) {
+    trace_->record(TRACE_PICKUP, tick_, index, pickup_floor, direction);
+  }
+  stats_.elevator_requests += elevator.request_count() - request_count;
+  if (vectorized_) {
+    fleet_.update(index, elevator);
+  }
+  pickup_group.accepted = true;
+  groups_hash_ ^= accepted_key(pickup_floor, direction);
+  pickup_floors.erase(pickup_floor);
+  --stats_.pending_groups;
+  ++stats_.accepted_groups;
+}
+
+bool sim::Scheduler::assign_pickups_batch() {
+  AssignmentSolver::clock::time_point deadline = AssignmentSolver::clock::now()
+    + std::chrono::microseconds(batch_budget_);
+
+  batch_pickups_.clear();
+  for (floor_t floor : up_pickups_) {
+    batch_pickups_.push_back(std::make_pair(floor, Direction::UP));
+  }
+  for (floor_t floor : down_pickups_) {
+    batch_pickups_.push_back(std::make_pair(floor, Direction::DOWN));
+  }
+  if (batch_pickups_.empty()) {
+    return true;
+  }
+
+  // Only elevators which would accept at least one of the pickups take part.
+  batch_elevators_.clear();
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    for (const std::pair<floor_t, Direction> &pickup : batch_pickups_) {
+      if (elevators[i].in_path(pickup.first, pickup.second)) {
+        batch_elevators_.push_back(i);
+        break;
+      }
     }
   }
-  // Check elevators for idle status
-  for (const Elevator &elevator : elevators) {
-    if (elevator.request_count() != 0) {
-      return false;
+  if (batch_elevators_.empty()) {
+    return true;
+  }
+
+  /* Build the cost matrix with the ETA of each elevator to each pickup. The
+   * solver needs at least as many columns as rows, so when there are more
+   * pickups than elevators, the pickups become the columns instead. Each
+   * elevator then gets at most one pickup from the batch. */
+  size_t pickup_count = batch_pickups_.size();
+  size_t elevator_count = batch_elevators_.size();
+  bool pickup_rows = pickup_count <= elevator_count;
+  size_t cols = pickup_rows ? elevator_count : pickup_count;
+  batch_costs_.resize(pickup_count * elevator_count);
+  int64_t max_cost = 0;
+  for (size_t p = 0; p < pickup_count; ++p) {
+    floor_t floor = batch_pickups_[p].first;
+    Direction direction = batch_pickups_[p].second;
+    for (size_t e = 0; e < elevator_count; ++e) {
+      const Elevator &elevator = elevators[batch_elevators_[e]];
+      int64_t cost = -1;
+      if (elevator.in_path(floor, direction)) {
+        cost = elevator.eta(floor, direction);
+        max_cost = std::max(max_cost, cost);
+      }
+      batch_costs_[pickup_rows ? p * cols + e : e * cols + p] = cost;
+    }
+  }
+  // Declined pairs cost more than any assignment of approved ones.
+  int64_t declined = (max_cost + 1) * std::min(pickup_count, elevator_count)
+    + 1;
+  for (int64_t &cost : batch_costs_) {
+    if (cost < 0) {
+      cost = declined;
+    }
+  }
+
+  size_t rows = pickup_rows ? pickup_count : elevator_count;
+  if (!solver_.solve(batch_costs_.data(), rows, cols, deadline,
+          batch_assignment_)) {
+    SIM_INFO("  Batch assignment ran out of time, assigning greedily");
+    return false;
+  }
+  for (size_t row = 0; row < rows; ++row) {
+    size_t col = batch_assignment_[row];
+    if (batch_costs_[row * cols + col] == declined) {
+      continue;
+    }
+    size_t p = pickup_rows ? row : col;
+    size_t index = batch_elevators_[pickup_rows ? col : row];
+    floor_t floor = batch_pickups_[p].first;
+    if (batch_pickups_[p].second == Direction::UP) {
+      assign_pickup(index, pending_up_requests[floor], up_pickups_, floor,
+          Direction::UP);
+    } else {
+      assign_pickup(index, pending_down_requests[floor], down_pickups_, floor,
+          Direction::DOWN);
     }
   }
   return true;
 }
 
-void sim::Scheduler::add_any_pickup_requests(std::vector<Elevator> &elevators,
-    std::vector<RequestGroup> &request_groups, Direction direction) {
-  for (floor_t pickup_floor = 0;
-       pickup_floor < request_groups.size(); ++pickup_floor) {
-    RequestGroup &pickup_group = request_groups[pickup_floor];
-    if (pickup_group.dests.empty()) {
-      // This pickup group is empty.
-      continue;
+int sim::Scheduler::select_rollout(floor_t pickup_floor, Direction direction) {
+  /* Find the candidates, and the one LOWEST_ETA would pick in case the
+   * rollouts can't be finished in time. */
+  rollout_candidates_.clear();
+  int best_index = -1;
+  LowestEtaPolicy::score_t best_eta;
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    if (elevators[i].approve_request(pickup_floor, direction)) {
+      rollout_candidates_.push_back(i);
+      LowestEtaPolicy::score_t eta =
+        LowestEtaPolicy::score(elevators[i], pickup_floor, direction);
+      if (best_index < 0 || eta < best_eta) {
+        best_index = i;
+        best_eta = eta;
+      }
     }
+  }
+  size_t count = rollout_candidates_.size();
+  if (count < 2) {
+    // Uncontested.
+    return best_index;
+  }
+  if (AssignmentSolver::clock::now() >= rollout_deadline_) {
+    SIM_INFO("  Rollout budget spent, assigning by ETA");
+    return best_index;
+  }
 
-    if (pickup_group.accepted) {
-      debug("  Pickup at %lu already accepted", pickup_floor);
-      // This pickup location is already accepted by an elevator.
-      continue;
+  // Run a rollout for each candidate, in parallel if there's a pool.
+  if (!rollout_snapshot_) {
+    rollout_snapshot_.reset(new Snapshot());
+  }
+  save(*rollout_snapshot_);
+  while (rollouts_.size() < count) {
+    rollouts_.emplace_back(
+        new Scheduler(pending_up_requests.size(), elevators.size()));
+    rollouts_.back()->set_dispatch(LOWEST_ETA);
+  }
+  // Passenger mode isn't part of the snapshot, and may have changed since
+  // the rollout schedulers were made.
+  for (size_t c = 0; c < count; ++c) {
+    rollouts_[c]->set_passengers(passenger_mode_, capacity_);
+  }
+  rollout_scores_.resize(count);
+  auto run = [this, pickup_floor, direction](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; ++c) {
+      rollout_scores_[c] = rollouts_[c]->rollout(*rollout_snapshot_,
+          rollout_candidates_[c], pickup_floor, direction, rollout_horizon_,
+          rollout_deadline_);
     }
+  };
+  if (pool_) {
+    pool_->parallel_for(count, run);
+  } else {
+    run(0, count);
+  }
 
-    /* Find the 'best' elevator to take this pickup request, among the elevators
-     * who are willing to take it. For now, we arbitrarily define 'best' as 'has
-     * fewest pending requests', but other criteria could be used as well. */
-    int best_index = -1;
-    for (size_t i = 0; i < elevators.size(); ++i) {
-      Elevator &elevator = elevators[i];
-      if (elevator.approve_request(pickup_floor, direction)) {
-        size_t request_count = elevator.request_count();
-        debug("  Pickup by elevator %lu (requests=%lu) at floor %lu approved",
-            i, request_count, pickup_floor);
-        // This elevator will accept the request, but is it better than our
-        // other options?
-        if (best_index < 0
-            || request_count < elevators[best_index].request_count()) {
-          best_index = i;
-        }
-      } else {
-        debug("  Pickup by elevator %lu at floor %lu declined", i, pickup_floor);
-      }
+  size_t best = 0;
+  for (size_t c = 0; c < count; ++c) {
+    if (rollout_scores_[c] == NO_SCORE) {
+      SIM_INFO("  Rollouts ran out of time, assigning by ETA");
+      return best_index;
     }
-    if (best_index >= 0) {
-      debug("  -> Pickup inserted into elevator %lu", best_index);
-      // Insert the request into the best elevator according to our criteria,
-      // then mark the RequestGroup as being accepted.
-      elevators[best_index].insert_request(pickup_floor, direction);
-      pickup_group.accepted = true;
+    SIM_DEBUG("  Rollout by elevator %lu scored %lu",
+        rollout_candidates_[c], rollout_scores_[c]);
+    if (rollout_scores_[c] < rollout_scores_[best]) {
+      best = c;
+    }
+  }
+  return rollout_candidates_[best];
+}
+
+uint64_t sim::Scheduler::rollout(const Snapshot &snapshot, size_t index,
+    floor_t pickup_floor, Direction direction, size_t horizon,
+    AssignmentSolver::clock::time_point deadline) {
+  restore(snapshot);
+  if (direction == Direction::UP) {
+    assign_pickup(index, pending_up_requests[pickup_floor], up_pickups_,
+        pickup_floor, direction);
+  } else {
+    assign_pickup(index, pending_down_requests[pickup_floor], down_pickups_,
+        pickup_floor, direction);
+  }
+  /* The first tick() finishes the tick which the snapshot was taken in, since
+   * the tick count hasn't moved on yet. Score the outstanding work after each
+   * tick, so that leaving requests waiting longer costs more. */
+  uint64_t score = 0;
+  for (size_t i = 0; i < horizon; ++i) {
+    if (AssignmentSolver::clock::now() >= deadline) {
+      return NO_SCORE;
     }
+    tick();
+    score += stats_.pending_dests + stats_.elevator_requests;
   }
+  return score;
 }
 
-void sim::Scheduler::add_dropoff_requests(Elevator &elevator,
+void sim::Scheduler::add_dropoff_requests(size_t index,
     RequestGroup &request_group, Direction direction) {
   // Pass all floors to the elevator.
+  Elevator &elevator = elevators[index];
 
-  debug("  -> %lu dropoff requests", request_group.dests.size());
+  SIM_DEBUG("  -> %lu dropoff requests", request_group.dests.size());
+  if (request_group.dests.empty()) {
+    return;
+  }
+  if (capacity_ != 0 && load_[index] + request_group.count > capacity_) {
+    // Not everyone fits.
+    board_some(index, request_group,
+        capacity_ - std::min<size_t>(load_[index], capacity_), direction);
+    return;
+  }
+  floor_t source = elevator.floor();
+  size_t request_count = elevator.request_count();
   for (floor_t floor : request_group.dests) {
+    groups_hash_ ^= dest_key(source, direction, floor);
     bool inserted = elevator.insert_request(floor, direction);
     // The elevator should really approve this request to drop off passengers.
     // It already approved the same direction for the pickup!
     assert(inserted);
+    (void)inserted;
+    if (trace_ != NULL) {
+      trace_->record(TRACE_DROPOFF, tick_, index, floor, direction);
+    }
+  }
+  stats_.elevator_requests += elevator.request_count() - request_count;
+  stats_.pending_dests -= request_group.dests.size();
+  groups_hash_ ^= count_key(source, direction, request_group.count);
+  board_riders(index, request_group);
+  if (request_group.accepted) {
+    groups_hash_ ^= accepted_key(source, direction);
+    --stats_.accepted_groups;
+  } else {
+    // Picked up by an elevator which happened to stop here.
+    --stats_.pending_groups;
+    if (direction == Direction::UP) {
+      up_pickups_.erase(elevator.floor());
+    } else {
+      down_pickups_.erase(elevator.floor());
+    }
   }
   // Reset the group, clearing the requests and unsetting the accept bit.
   request_group.dests.clear();
   request_group.accepted = false;
 }
+
+void sim::Scheduler::board_some(size_t index, RequestGroup &request_group,
+    size_t boarding, Direction direction) {
+  Elevator &elevator = elevators[index];
+  floor_t floor = elevator.floor();
+  floor_t floors = pending_up_requests.size();
+  SIM_DEBUG("  -> Elevator full: %lu of %u passengers boarding", boarding,
+      request_group.count);
+
+  /* Board from the front of the waiting list. The first passenger for each
+   * destination takes it out of the group and passes it to the elevator. */
+  size_t request_count = elevator.request_count();
+  uint32_t passenger = request_group.waiting;
+  for (size_t i = 0; i < boarding; ++i) {
+    floor_t dest = passengers_.dest(passenger);
+    if (request_group.dests.erase(dest)) {
+      groups_hash_ ^= dest_key(floor, direction, dest);
+      bool inserted = elevator.insert_request(dest, direction);
+      assert(inserted);
+      (void)inserted;
+      if (trace_ != NULL) {
+        trace_->record(TRACE_DROPOFF, tick_, index, dest, direction);
+      }
+      --stats_.pending_dests;
+    }
+    latency_.wait.record(uint32_t(tick_) - passengers_.tick(passenger));
+    passengers_.set_tick(passenger, tick_);
+    passengers_.set_car(passenger, index);
+    uint32_t next = passengers_.next(passenger);
+    passengers_.set_next(passenger, riders_[index * floors + dest]);
+    riders_[index * floors + dest] = passenger;
+    passenger = next;
+  }
+  stats_.elevator_requests += elevator.request_count() - request_count;
+  load_[index] += boarding;
+  stats_.waiting -= boarding;
+  stats_.riding += boarding;
+  request_group.waiting = passenger;
+  groups_hash_ ^= count_key(floor, direction, request_group.count)
+    ^ count_key(floor, direction, request_group.count - boarding);
+  request_group.count -= boarding;
+
+  // Everyone left behind presses the button again.
+  for (; passenger != NO_REQUEST; passenger = passengers_.next(passenger)) {
+    floor_t dest = passengers_.dest(passenger);
+    if (request_group.dests.insert(dest)) {
+      groups_hash_ ^= dest_key(floor, direction, dest);
+      ++stats_.pending_dests;
+      if (trace_ != NULL) {
+        trace_->record(TRACE_REQUEST, tick_, 0, floor, dest);
+      }
+    }
+  }
+  /* Hold the pickup back until this elevator has moved on, so that it isn't
+   * handed straight back to it while it's still full. */
+  if (request_group.accepted) {
+    groups_hash_ ^= accepted_key(floor, direction);
+    --stats_.accepted_groups;
+    ++stats_.pending_groups;
+    request_group.accepted = false;
+  } else if (direction == Direction::UP) {
+    up_pickups_.erase(floor);
+  } else {
+    down_pickups_.erase(floor);
+  }
+  held_.push_back(std::make_pair(floor, direction));
+}
+
+void sim::Scheduler::board_riders(size_t index, RequestGroup &request_group) {
+  // Record the wait for everyone in the group, then move each of them onto
+  // the elevator's list for their destination.
+  floor_t floors = pending_up_requests.size();
+  uint32_t next;
+  for (uint32_t i = request_group.waiting; i != NO_REQUEST; i = next) {
+    latency_.wait.record(uint32_t(tick_) - passengers_.tick(i));
+    passengers_.set_tick(i, tick_);
+    passengers_.set_car(i, index);
+    uint32_t &riders = riders_[index * floors + passengers_.dest(i)];
+    next = passengers_.next(i);
+    passengers_.set_next(i, riders);
+    riders = i;
+  }
+  load_[index] += request_group.count;
+  stats_.waiting -= request_group.count;
+  stats_.riding += request_group.count;
+  request_group.waiting = NO_REQUEST;
+  request_group.last = NO_REQUEST;
+  request_group.count = 0;
+}
+
+void sim::Scheduler::drop_off_riders(size_t index, floor_t floor) {
+  // Everyone on this elevator's list for this floor gets off.
+  uint32_t &riders = riders_[index * pending_up_requests.size() + floor];
+  size_t count = 0;
+  uint32_t next;
+  for (uint32_t i = riders; i != NO_REQUEST; i = next) {
+    latency_.travel.record(uint32_t(tick_) - passengers_.tick(i));
+    if (arrivals_ != NULL) {
+      arrivals_->push_back(Arrival(passengers_.source(i), floor,
+          tick_ - (uint32_t(tick_) - passengers_.tick(i)), tick_));
+    }
+    next = passengers_.next(i);
+    passengers_.remove(i);
+    ++count;
+  }
+  riders = NO_REQUEST;
+  load_[index] -= count;
+  stats_.riding -= count;
+}
+
+void sim::Scheduler::release_held_pickups(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    floor_t floor = held_[i].first;
+    Direction direction = held_[i].second;
+    RequestGroup &group = (direction == Direction::UP)
+      ? pending_up_requests[floor] : pending_down_requests[floor];
+    // The group may have been picked up by another elevator in the meantime.
+    if (!group.dests.empty() && !group.accepted) {
+      ((direction == Direction::UP) ? up_pickups_ : down_pickups_)
+        .insert(floor);
+    }
+  }
+  held_.erase(held_.begin(), held_.begin() + count);
+}
+
+void sim::Scheduler::record_state_hash(size_t tick) {
+  uint64_t hash = state_hash();
+  if (hash_check_ && hash_mismatch_tick_ == 0
+      && hash != compute_state_hash()) {
+    SIM_INFO("  State hash doesn't match the state at tick %lu", tick);
+    hash_mismatch_tick_ = tick;
+  }
+  if (trace_ != NULL) {
+    trace_->record(TRACE_HASH, tick, 0, uint32_t(hash), uint32_t(hash >> 32));
+  }
+}
+
+sim::Scheduler::Snapshot::Snapshot()
+  : floors_(0),
+    groups_hash_(0),
+    tick_(1) { }
+
+sim::Scheduler::Snapshot::Snapshot(const Snapshot &other) = default;
+
+sim::Scheduler::Snapshot &sim::Scheduler::Snapshot::operator=(
+    const Snapshot &other) = default;
+
+sim::Scheduler::Snapshot::~Snapshot() {
+}
+
+size_t sim::Scheduler::Snapshot::tick_count() const {
+  return tick_ - 1;
+}
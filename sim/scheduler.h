@@ -1,12 +1,123 @@
 #ifndef _sim_scheduler_h_
 #define _sim_scheduler_h_
 
+#include <memory>
+#include <queue>
+#include <utility>
 #include <vector>
 
+#include "sim/arena.h"
+#include "sim/assignment.h"
+#include "sim/dispatch.h"
 #include "sim/elevator.h"
+#include "sim/fleet.h"
+#include "sim/histogram.h"
+#include "sim/passengers.h"
+#include "sim/profile.h"
+#include "sim/thread_pool.h"
 
 namespace sim {
   class RequestGroup;
+  class RequestQueue;
+  class TraceWriter;
+
+  /**
+   * Counters of the outstanding work in a Scheduler. These are updated as
+   * requests move through the Scheduler, so reading them is constant time.
+   */
+  class SchedulerStats {
+   public:
+    SchedulerStats()
+      : pending_groups(0), accepted_groups(0),
+        pending_dests(0), elevator_requests(0), waiting(0), riding(0) { }
+
+    // Pickup groups with requests which no elevator has accepted yet.
+    size_t pending_groups;
+
+    // Pickup groups which an elevator has accepted but not yet arrived at.
+    size_t accepted_groups;
+
+    // Destination floors held in pickup groups, whether accepted or not.
+    size_t pending_dests;
+
+    // Floor requests queued across all elevators.
+    size_t elevator_requests;
+
+    // Requests waiting to be picked up, and riding in elevators. In passenger
+    // mode, these count passengers rather than distinct requests.
+    size_t waiting, riding;
+  };
+
+  /**
+   * How the Scheduler picks among the elevators which would accept a pickup.
+   */
+  enum Dispatch {
+    // The elevator with the fewest queued requests. This is the default.
+    FEWEST_REQUESTS,
+
+    // The elevator which would open its doors at the pickup floor soonest,
+    // counting both travel and the stops it already has queued on the way.
+    // Ties go to the elevator with fewer requests.
+    LOWEST_ETA,
+
+    // All waiting pickups are assigned together each tick, minimizing the
+    // total ETA with each elevator taking at most one of them. Pickups left
+    // over are then assigned as with LOWEST_ETA, as are all of them if the
+    // batch can't be solved within the time budget.
+    BATCH,
+
+    // When several elevators would accept a pickup, each of them is given it
+    // in a copy of the simulation which is run a few dozen ticks ahead, and
+    // the one which leaves the least outstanding work wins. Pickups are
+    // assigned as with LOWEST_ETA once the time budget for a tick runs out.
+    ROLLOUT,
+
+    // A policy set with Scheduler::set_dispatch_policy().
+    CUSTOM_POLICY
+  };
+
+  /**
+   * Returns a short name for the provided Dispatch, as accepted by
+   * parse_dispatch().
+   */
+  const char *string(Dispatch dispatch);
+
+  /**
+   * Sets 'dispatch' to the Dispatch with the provided short name ("fewest",
+   * "eta", "batch" or "rollout"). Returns false if the name isn't recognized.
+   */
+  bool parse_dispatch(const char *name, Dispatch &dispatch);
+
+  /**
+   * How long requests have taken to be served, in ticks. Each request is
+   * timed from its insert_request() until an elevator opens its doors at the
+   * source floor to pick it up ('wait'), and from then until an elevator
+   * opens its doors at the destination floor ('travel').
+   */
+  class LatencyStats {
+   public:
+    Histogram wait;
+    Histogram travel;
+  };
+
+  /**
+   * A request which has been dropped off at its destination, as reported to
+   * Scheduler::set_arrivals(). Identical requests which were merged while
+   * waiting are only reported once, unless passenger mode is enabled.
+   */
+  class Arrival {
+   public:
+    Arrival(floor_t source = 0, floor_t dest = 0, size_t pickup_tick = 0,
+        size_t dropoff_tick = 0)
+      : source(source), dest(dest), pickup_tick(pickup_tick),
+        dropoff_tick(dropoff_tick) { }
+
+    floor_t source, dest;
+
+    // The ticks when an elevator opened its doors at the source and the
+    // destination.
+    size_t pickup_tick, dropoff_tick;
+  };
 
   /**
    * The scheduler handles incoming requests and hands them out to Elevators.
@@ -18,32 +129,274 @@ namespace sim {
    public:
     /**
      * Creates a new scheduler which operates on the provided quantity of
-     * floors and elevators. Verbose logging may be enabled to print internal
-     * state on every tick.
+     * floors and elevators. Verbose logging may be enabled via
+     * sim::verbose_enabled to print internal state on every tick, for any log
+     * levels which were compiled in (see sim/logging.h).
      */
     Scheduler(floor_t floors, size_t elevators);
     virtual ~Scheduler();
 
+    /**
+     * Returns the scheduler to the state it was created in, with every
+     * elevator idle at floor 0 and no requests or latency history, while
+     * keeping settings such as the dispatch and threads. The memory for the
+     * simulation state is reused, so this is much cheaper than creating a new
+     * Scheduler, eg when running many short simulations back to back.
+     */
+    void reset();
+
+    /**
+     * A checkpoint of a Scheduler's simulation state, from save().
+     */
+    class Snapshot;
+
+    /**
+     * Saves the simulation state to the provided snapshot: the elevators, the
+     * pending and scheduled requests, the tick count, stats and latencies.
+     * Settings such as the dispatch, threads and trace aren't included, so a
+     * snapshot may be restored and run with different settings. The state is
+     * flat, so saving is a handful of memcpys, and reuses the snapshot's
+     * memory when it's saved to again.
+     */
+    void save(Snapshot &snapshot) const;
+
+    /**
+     * Replaces the simulation state with a snapshot from save(), on this
+     * scheduler or any other with the same number of floors and elevators.
+     * Returns false, without changing anything, if the dimensions don't
+     * match.
+     */
+    bool restore(const Snapshot &snapshot);
+
+    /**
+     * Returns an independent copy of this scheduler, with the same state and
+     * settings apart from the trace, which isn't copied. This is the same as
+     * restoring a snapshot into a new Scheduler.
+     */
+    std::unique_ptr<Scheduler> fork() const;
+
     /**
      * Inserts a new elevator request. Returns true if the request was inserted,
      * or false if it was ignored. Requests may be ignored if they are invalid
-     * or if an identical request has already been queued.
+     * or if an identical request has already been queued. In passenger mode,
+     * identical requests are separate passengers, so only invalid requests
+     * are ignored.
      */
     bool insert_request(floor_t source, floor_t dest);
 
+    /**
+     * Queues a request to be inserted at the start of the provided tick, where
+     * the first tick is 1. Requests for ticks which have already started are
+     * inserted at the start of the next tick. Returns false if the request is
+     * invalid. Identical requests are merged once they're inserted.
+     */
+    bool schedule_request(size_t tick, floor_t source, floor_t dest);
+
     /**
      * Runs the simulation for a step, updating Elevator and request state in
      * the process. This must be called repeatedly to move the simulation along.
      */
     void tick();
 
+    /**
+     * Runs the simulation until the provided number of ticks have elapsed in
+     * total. Stretches of ticks where the only thing happening is elevators
+     * travelling towards their next floor are skipped over in a single step,
+     * with the same end result as calling tick() for each of them.
+     */
+    void run_until(size_t ticks);
+
+    /**
+     * Skips ahead to the next tick where something other than elevator travel
+     * can happen: an elevator reaching a queued floor, a scheduled request
+     * arriving, or a held pickup becoming approvable. That tick is then run.
+     * Returns the number of ticks which elapsed, or 0 if nothing will ever
+     * happen again without new requests.
+     */
+    size_t advance_to_next_event();
+
+    /**
+     * Returns the number of ticks which have elapsed so far.
+     */
+    size_t tick_count() const;
+
     /**
      * Returns whether the scheduler is idle, which is when no requests remain
-     * to be completed. This may be called to determine if the simulation has
-     * serviced all inserted requests.
+     * to be completed, including any scheduled requests which haven't arrived
+     * yet. This may be called to determine if the simulation has serviced all
+     * inserted requests.
      */
     bool idle() const;
 
+    /**
+     * Returns counters of the work which is currently outstanding in this
+     * scheduler.
+     */
+    const SchedulerStats &stats() const;
+
+    /**
+     * Returns the wait and travel times of the requests which have been
+     * picked up and dropped off so far. Requests which are still waiting or
+     * riding aren't included.
+     */
+    const LatencyStats &latency() const;
+
+    /**
+     * Returns the time spent in each phase of tick() so far, if profiling was
+     * compiled in with SIM_PROFILE (see sim/profile.h). Stretches skipped by
+     * run_until() and advance_to_next_event() aren't timed.
+     */
+    const PhaseTimings &phase_timings() const;
+
+    /**
+     * Returns a 64-bit hash of the simulation state: each elevator's floor,
+     * direction and queued floors, and each pickup group's destinations,
+     * whether it's been accepted, and how many passengers are waiting. Two
+     * schedulers with the same hash have made the same decisions so far,
+     * barring a collision, so this is a quick way to check that a faster
+     * implementation still matches the reference one. It's kept up to date
+     * as the state changes, so this only combines one value per elevator.
+     * Requests which are scheduled or queued but not yet inserted, and
+     * latency history, aren't included.
+     */
+    uint64_t state_hash() const;
+
+    /**
+     * Works out the same value as state_hash() from scratch, to check it.
+     * This visits every floor of every elevator and pickup group.
+     */
+    uint64_t compute_state_hash() const;
+
+    /**
+     * Enables or disables checking state_hash() against
+     * compute_state_hash() at the end of every tick. This is slow, and is
+     * meant for testing changes to how the state is kept. Mismatches are
+     * reported by hash_mismatch_tick().
+     */
+    void set_hash_check(bool enabled);
+
+    /**
+     * Returns the first tick where the check from set_hash_check() failed,
+     * or 0 if it hasn't.
+     */
+    size_t hash_mismatch_tick() const;
+
+    /**
+     * Enables or disables vectorized pickup assignment. When enabled, the
+     * scheduler keeps a structure-of-arrays Fleet mirror of its Elevators and
+     * picks the elevator for each pickup in a single SIMD pass. Assignments
+     * are identical either way, but per-elevator approval isn't logged.
+     */
+    void set_vectorized(bool enabled);
+
+    /**
+     * Sets how a pickup is assigned when several elevators would accept it.
+     * In all cases, remaining ties go to the lowest-numbered elevator. The
+     * default is FEWEST_REQUESTS. Vectorized assignment (see
+     * set_vectorized()) only applies to FEWEST_REQUESTS.
+     */
+    void set_dispatch(Dispatch dispatch);
+
+    /**
+     * Picks among the elevators which would accept a pickup with the provided
+     * policy, as described in sim/dispatch.h. The policy's scoring is
+     * compiled into its own copy of the selection loop, so it costs the same
+     * as the built-in ones.
+     */
+    template <typename Policy>
+    void set_dispatch_policy() {
+      dispatch_ = CUSTOM_POLICY;
+      select_ = &select_car<Policy, Elevator>;
+    }
+
+    /**
+     * Sets the wall-clock time allowed for solving each tick's BATCH
+     * assignment, after which that tick falls back to assigning pickups one
+     * at a time. The default is 1000 microseconds. Since this depends on the
+     * speed of the machine, runs which hit the budget may not be repeatable.
+     */
+    void set_batch_budget(size_t microseconds);
+
+    /**
+     * Sets the number of ticks which ROLLOUT simulates ahead for each
+     * candidate elevator, and the wall-clock time allowed for all of the
+     * rollouts in a tick. Each rollout runs the rest of the current tick and
+     * then 'horizon' - 1 more with LOWEST_ETA dispatch and no new requests
+     * beyond those already scheduled, summing the pending destinations and
+     * queued elevator requests after each tick. Rollouts run in parallel on
+     * the threads from set_threads(). Any pickups left once the budget has
+     * run out are assigned as with LOWEST_ETA, so runs which hit the budget
+     * may not be repeatable. The defaults are 32 ticks and 1000 microseconds.
+     */
+    void set_rollout(size_t horizon, size_t microseconds);
+
+    /**
+     * Sets the number of threads used to run elevator ticks. With more than
+     * one thread, all elevators are advanced in parallel on a persistent
+     * thread pool, then their dropoffs are handed over in elevator order so
+     * that results match a single-threaded run exactly. A value of 0 uses one
+     * thread per hardware core. The default is 1. Debug output from the
+     * elevators themselves may be interleaved when running in parallel.
+     */
+    void set_threads(size_t threads);
+
+    /**
+     * Records every inserted request, pickup assignment, dropoff handoff and
+     * non-idle elevator Action to the provided trace, along with the
+     * state_hash() at the end of each tick, or stops recording if it's NULL.
+     * The trace isn't owned by the scheduler, and must have been opened with
+     * this scheduler's dimensions.
+     */
+    void set_trace(TraceWriter *trace);
+
+    /**
+     * Appends every request which is dropped off from now on to the provided
+     * vector, or stops doing so if it's NULL. The vector isn't owned by the
+     * scheduler, and it's up to the caller to empty it. Like the trace, this
+     * isn't part of a Snapshot and isn't copied by fork().
+     */
+    void set_arrivals(std::vector<Arrival> *arrivals);
+
+    /**
+     * Drains the provided queue at the start of every tick, inserting its
+     * requests as if insert_request() had been called for each, or stops
+     * draining if it's NULL. This lets other threads submit requests while
+     * the simulation runs, as tick() is the only thing which reads the
+     * queue. Each tick only drains what was queued when it started, so
+     * producers which keep submitting can't make a tick overrun. The queue
+     * isn't owned by the scheduler. Requests which are still in the queue
+     * don't count towards idle(), and while a queue is set, run_until() and
+     * advance_to_next_event() don't skip any ticks.
+     */
+    void set_request_queue(RequestQueue *queue);
+
+    /**
+     * Enables or disables passenger mode. By default, identical requests
+     * which are waiting at the same floor are merged into one. In passenger
+     * mode, every request is a separate passenger, with its own wait and
+     * travel times, and each elevator carries at most 'capacity' passengers
+     * at once, or any number if it's 0.
+     *
+     * When a full elevator opens its doors at a pickup, passengers board in
+     * the order they arrived until it's full. Anyone left behind has their
+     * pickup put back up for assignment once that elevator has left, as if
+     * they had pressed the button again. Boarding and dropping off only visit
+     * the passengers at that stop. This must only be changed while the
+     * scheduler is idle.
+     */
+    void set_passengers(bool enabled, size_t capacity);
+
+    /**
+     * Returns the passengers in the building, in passenger mode, or the
+     * requests being timed otherwise.
+     */
+    const PassengerStore &passengers() const;
+
+    /**
+     * Returns the number of passengers riding in the provided elevator.
+     */
+    size_t load(size_t elevator) const;
+
    protected:
     /**
      * The elevators which are being simulated. Visible for testing.
@@ -59,12 +412,197 @@ namespace sim {
 
    private:
     void add_any_pickup_requests(std::vector<Elevator> &elevators,
-        std::vector<RequestGroup> &request_groups, Direction direction);
-    void add_dropoff_requests(Elevator &elevator, RequestGroup &request_group,
+        std::vector<RequestGroup> &request_groups, FloorSet &pickup_floors,
         Direction direction);
-    void verbose(const char *format, ...) const;
+    void assign_pickup(size_t index, RequestGroup &pickup_group,
+        FloorSet &pickup_floors, floor_t pickup_floor, Direction direction);
+    bool assign_pickups_batch();
+    int select_rollout(floor_t pickup_floor, Direction direction);
+    uint64_t rollout(const Snapshot &snapshot, size_t index,
+        floor_t pickup_floor, Direction direction, size_t horizon,
+        AssignmentSolver::clock::time_point deadline);
+    size_t quiet_ticks() const;
+    void skip_ticks(size_t ticks);
+    void finish_elevator_tick(size_t index, Action action);
+    void add_dropoff_requests(size_t index, RequestGroup &request_group,
+        Direction direction);
+    void board_some(size_t index, RequestGroup &request_group,
+        size_t boarding, Direction direction);
+    void board_riders(size_t index, RequestGroup &request_group);
+    void drop_off_riders(size_t index, floor_t floor);
+    void release_held_pickups(size_t count);
+    void record_state_hash(size_t tick);
+    void build_state(floor_t floors, size_t elevator_count);
+
+    /**
+     * Storage for the FloorSets of 'elevators', the pending request groups and
+     * the pickup indexes, sized so that they all fit in its first block.
+     */
+    Arena arena_;
+
+    size_t tick_;
+    SchedulerStats stats_;
+
+    /**
+     * The pickup groups' part of state_hash(). Each elevator keeps its own.
+     * With 'hash_check_' set, the first tick where it didn't match the state
+     * is kept in 'hash_mismatch_tick_'.
+     */
+    uint64_t groups_hash_;
+    bool hash_check_;
+    size_t hash_mismatch_tick_;
 
+    /**
+     * Index of the floors whose pickup groups have requests but haven't been
+     * accepted by an elevator, so that tick() only visits those floors.
+     */
+    FloorSet up_pickups_, down_pickups_;
+
+    /**
+     * Mirror of 'elevators', only kept up to date while 'vectorized_' is set.
+     */
+    Fleet fleet_;
+    bool vectorized_;
+
+    /**
+     * The selection loop for the current dispatch, compiled for its policy.
+     */
+    typedef int (*select_t)(std::vector<Elevator> &elevators, floor_t floor,
+        Direction direction);
+    Dispatch dispatch_;
+    select_t select_;
+
+    /**
+     * Time budget and working state for BATCH assignment, kept between ticks
+     * to avoid reallocating.
+     */
+    size_t batch_budget_;
+    AssignmentSolver solver_;
+    std::vector<std::pair<floor_t, Direction> > batch_pickups_;
+    std::vector<size_t> batch_elevators_, batch_assignment_;
+    std::vector<int64_t> batch_costs_;
+
+    /**
+     * Settings and working state for ROLLOUT assignment. Each candidate
+     * elevator for a pickup gets its own scheduler in 'rollouts_' to run
+     * ahead in, which is created on first use and restored from
+     * 'rollout_snapshot_' each time.
+     */
+    size_t rollout_horizon_, rollout_budget_;
+    AssignmentSolver::clock::time_point rollout_deadline_;
+    std::unique_ptr<Snapshot> rollout_snapshot_;
+    std::vector<std::unique_ptr<Scheduler> > rollouts_;
+    std::vector<size_t> rollout_candidates_;
+    std::vector<uint64_t> rollout_scores_;
+
+    /**
+     * Pool for parallel elevator ticks, or NULL if they're run serially.
+     * 'actions_' holds each elevator's result until they've all ticked.
+     */
+    std::unique_ptr<ThreadPool> pool_;
+    std::vector<Action> actions_;
+
+    /**
+     * Requests being timed for 'latency_', one per passenger in passenger
+     * mode. Each is linked into its pickup group's 'waiting' list, then into
+     * the 'riders_' list for the elevator which picked it up and its
+     * destination, at index elevator * floors + dest. 'load_' counts each
+     * elevator's riders.
+     */
+    PassengerStore passengers_;
+    std::vector<uint32_t> riders_;
+    std::vector<uint32_t> load_;
+    LatencyStats latency_;
+
+    /**
+     * Passenger mode settings, and pickups which had passengers left behind
+     * by a full elevator. Those are put back into the pickup indexes once
+     * the elevators have ticked again, so that the full one has moved on.
+     */
+    bool passenger_mode_;
+    size_t capacity_;
+    std::vector<std::pair<floor_t, Direction> > held_;
+    PhaseTimings phases_;
+
+    /**
+     * Destination for trace records, or NULL if tracing is disabled.
+     */
+    TraceWriter *trace_;
+
+    /**
+     * Destination for dropped off requests, or NULL if they aren't wanted.
+     */
+    std::vector<Arrival> *arrivals_;
+
+    /**
+     * Queue of requests from other threads, or NULL if there isn't one, and
+     * a buffer to drain it into.
+     */
+    RequestQueue *queue_;
+    std::vector<Request> queue_buffer_;
+
+    /**
+     * Orders scheduled requests so that the earliest is at the top.
+     */
+    class LaterRequest {
+     public:
+      bool operator()(const Request &a, const Request &b) const {
+        return a.tick > b.tick;
+      }
+    };
+
+    /**
+     * Requests which are waiting for their tick to arrive.
+     */
+    std::priority_queue<Request, std::vector<Request>, LaterRequest> scheduled_;
+  };
+
+  class Scheduler::Snapshot {
+   public:
+    Snapshot();
+    Snapshot(const Snapshot &other);
+    Snapshot &operator=(const Snapshot &other);
+    virtual ~Snapshot();
+
+    /**
+     * Returns the tick_count() of the scheduler when it was saved.
+     */
+    size_t tick_count() const;
+
+   private:
+    friend class Scheduler;
+
+    floor_t floors_;
+
+    /**
+     * The Scheduler's arena, holding the words of all of its FloorSets.
+     */
+    std::vector<char> arena_;
+
+    /**
+     * Everything apart from the FloorSets of a request group, for each up
+     * request group followed by each down request group.
+     */
+    class Group {
+     public:
+      bool accepted;
+      uint32_t waiting, last, count;
+    };
+
+    /**
+     * Everything else, which is either scalar or trivially copyable.
+     */
+    std::vector<Elevator::State> elevators_;
+    std::vector<Group> groups_;
+    uint64_t groups_hash_;
     size_t tick_;
+    SchedulerStats stats_;
+    PassengerStore passengers_;
+    std::vector<uint32_t> riders_;
+    std::vector<uint32_t> load_;
+    LatencyStats latency_;
+    std::vector<std::pair<floor_t, Direction> > held_;
+    std::priority_queue<Request, std::vector<Request>, LaterRequest> scheduled_;
   };
 }
 
@@ -0,0 +1,394 @@
+#include "sim/sweep.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+  const char MAGIC[8] = {'E', 'L', 'E', 'V', 'S', 'W', 'P', '\0'};
+  const uint32_t VERSION = 1;
+
+  // Runs per thread between checkpoints, unless the caller picks a number.
+  const size_t CHECKPOINT_PER_THREAD = 64;
+
+  class ColumnDef {
+   public:
+    const char *name;
+    sim::SweepType type;
+  };
+
+  const ColumnDef COLUMNS[sim::COLUMN_COUNT] = {
+    {"floors", sim::SWEEP_UINT32},
+    {"elevators", sim::SWEEP_UINT32},
+    {"pattern", sim::SWEEP_UINT8},
+    {"dispatch", sim::SWEEP_UINT8},
+    {"rate", sim::SWEEP_DOUBLE},
+    {"seed", sim::SWEEP_UINT64},
+    {"done", sim::SWEEP_UINT8},
+    {"completed", sim::SWEEP_UINT8},
+    {"ticks", sim::SWEEP_UINT64},
+    {"inserted", sim::SWEEP_UINT64},
+    {"delivered", sim::SWEEP_UINT64},
+    {"wait_mean", sim::SWEEP_DOUBLE},
+    {"wait_p99", sim::SWEEP_UINT64},
+    {"wait_max", sim::SWEEP_UINT64},
+    {"travel_mean", sim::SWEEP_DOUBLE},
+    {"travel_p99", sim::SWEEP_UINT64},
+    {"travel_max", sim::SWEEP_UINT64}
+  };
+
+  size_t type_width(sim::SweepType type) {
+    switch (type) {
+      case sim::SWEEP_UINT8: return 1;
+      case sim::SWEEP_UINT32: return 4;
+      case sim::SWEEP_UINT64: return 8;
+      case sim::SWEEP_DOUBLE: return 8;
+    }
+    return 0;
+  }
+
+  inline uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+  }
+
+  /**
+   * Works out where each column goes in a file with the provided number of
+   * runs, returning the total file size.
+   */
+  size_t layout(size_t runs, uint64_t *offsets) {
+    uint64_t offset = align8(sizeof(sim::SweepHeader)
+        + sim::COLUMN_COUNT * sizeof(sim::SweepColumnInfo));
+    for (int i = 0; i < sim::COLUMN_COUNT; ++i) {
+      offsets[i] = offset;
+      offset = align8(offset + runs * type_width(COLUMNS[i].type));
+    }
+    return offset;
+  }
+
+  // The grid's axes, where an empty axis keeps the base value.
+  inline size_t axis_size(size_t size) {
+    return (size == 0) ? 1 : size;
+  }
+
+  template <typename T>
+  inline T axis_value(const std::vector<T> &axis, size_t &run, T base) {
+    if (axis.empty()) {
+      return base;
+    }
+    T value = axis[run % axis.size()];
+    run /= axis.size();
+    return value;
+  }
+}
+
+size_t sim::SweepGrid::size() const {
+  return axis_size(floors.size()) * axis_size(elevators.size())
+      * axis_size(patterns.size()) * axis_size(rates.size())
+      * axis_size(dispatches.size()) * axis_size(seeds);
+}
+
+sim::Scenario sim::SweepGrid::at(size_t run) const {
+  assert(run < size());
+  Scenario scenario = base;
+  // From the fastest varying axis to the slowest.
+  scenario.seed = base.seed + run % axis_size(seeds);
+  run /= axis_size(seeds);
+  scenario.dispatch = axis_value(dispatches, run, base.dispatch);
+  scenario.rate = axis_value(rates, run, base.rate);
+  scenario.pattern = axis_value(patterns, run, base.pattern);
+  scenario.elevators = axis_value(elevators, run, base.elevators);
+  scenario.floors = axis_value(floors, run, base.floors);
+  return scenario;
+}
+
+const char *sim::string(SweepColumn column) {
+  if (column < 0 || column >= COLUMN_COUNT) {
+    return "?";
+  }
+  return COLUMNS[column].name;
+}
+
+sim::SweepFile::SweepFile()
+  : map_(NULL), map_size_(0), writable_(false), size_(0) {
+  memset(offsets_, 0, sizeof(offsets_));
+}
+
+sim::SweepFile::~SweepFile() {
+  close();
+}
+
+size_t sim::SweepFile::width(SweepColumn column) {
+  return type_width(COLUMNS[column].type);
+}
+
+bool sim::SweepFile::map(const char *path, bool writable, size_t size) {
+  close();
+  // Only create the file if a size was provided.
+  int fd = !writable ? ::open(path, O_RDONLY)
+    : (size != 0) ? ::open(path, O_RDWR | O_CREAT, 0644)
+    : ::open(path, O_RDWR);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  if (size != 0) {
+    // Creating a new file: drop any old contents, then zero-fill it.
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0) {
+      ::close(fd);
+      return false;
+    }
+  } else {
+    size = st.st_size;
+  }
+  if (size < sizeof(SweepHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+      MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  map_ = map;
+  map_size_ = size;
+  writable_ = writable;
+  return true;
+}
+
+bool sim::SweepFile::valid() const {
+  const SweepHeader &h = header();
+  if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION
+      || h.column_count != COLUMN_COUNT) {
+    return false;
+  }
+  uint64_t offsets[COLUMN_COUNT];
+  if (layout(h.runs, offsets) != map_size_) {
+    return false;
+  }
+  const SweepColumnInfo *info = (const SweepColumnInfo*)(&h + 1);
+  for (int i = 0; i < COLUMN_COUNT; ++i) {
+    if (strncmp(info[i].name, COLUMNS[i].name, sizeof(info[i].name)) != 0
+        || info[i].type != uint32_t(COLUMNS[i].type)
+        || info[i].width != type_width(COLUMNS[i].type)
+        || info[i].offset != offsets[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool sim::SweepFile::open(const char *path) {
+  if (!map(path, false, 0)) {
+    return false;
+  }
+  if (!valid()) {
+    close();
+    return false;
+  }
+  size_ = header().runs;
+  layout(size_, offsets_);
+  return true;
+}
+
+bool sim::SweepFile::create(const char *path, const SweepGrid &grid) {
+  size_t runs = grid.size();
+  if (!map(path, true, layout(runs, offsets_))) {
+    return false;
+  }
+  size_ = runs;
+
+  SweepHeader &h = *(SweepHeader*)map_;
+  h.version = VERSION;
+  h.column_count = COLUMN_COUNT;
+  h.runs = runs;
+  h.requests = grid.base.requests;
+  h.max_ticks = grid.base.max_ticks;
+  h.capacity = grid.base.capacity;
+  h.passengers = grid.base.passengers;
+  SweepColumnInfo *info = (SweepColumnInfo*)(&h + 1);
+  for (int i = 0; i < COLUMN_COUNT; ++i) {
+    strncpy(info[i].name, COLUMNS[i].name, sizeof(info[i].name));
+    info[i].type = COLUMNS[i].type;
+    info[i].width = type_width(COLUMNS[i].type);
+    info[i].offset = offsets_[i];
+  }
+
+  uint32_t *floors = mutable_column<uint32_t>(COLUMN_FLOORS);
+  uint32_t *elevators = mutable_column<uint32_t>(COLUMN_ELEVATORS);
+  uint8_t *patterns = mutable_column<uint8_t>(COLUMN_PATTERN);
+  uint8_t *dispatches = mutable_column<uint8_t>(COLUMN_DISPATCH);
+  double *rates = mutable_column<double>(COLUMN_RATE);
+  uint64_t *seeds = mutable_column<uint64_t>(COLUMN_SEED);
+  for (size_t run = 0; run < runs; ++run) {
+    Scenario scenario = grid.at(run);
+    floors[run] = scenario.floors;
+    elevators[run] = scenario.elevators;
+    patterns[run] = scenario.pattern;
+    dispatches[run] = scenario.dispatch;
+    rates[run] = scenario.rate;
+    seeds[run] = scenario.seed;
+  }
+
+  // The magic goes in last, so a file which was only partly created won't
+  // be mistaken for a valid one.
+  if (!sync()) {
+    return false;
+  }
+  memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  return sync();
+}
+
+bool sim::SweepFile::matches(const SweepGrid &grid) const {
+  const SweepHeader &h = header();
+  if (h.runs != grid.size() || h.requests != grid.base.requests
+      || h.max_ticks != grid.base.max_ticks
+      || h.capacity != grid.base.capacity
+      || h.passengers != uint32_t(grid.base.passengers)) {
+    return false;
+  }
+  const uint32_t *floors = column<uint32_t>(COLUMN_FLOORS);
+  const uint32_t *elevators = column<uint32_t>(COLUMN_ELEVATORS);
+  const uint8_t *patterns = column<uint8_t>(COLUMN_PATTERN);
+  const uint8_t *dispatches = column<uint8_t>(COLUMN_DISPATCH);
+  const double *rates = column<double>(COLUMN_RATE);
+  const uint64_t *seeds = column<uint64_t>(COLUMN_SEED);
+  for (size_t run = 0; run < size_; ++run) {
+    Scenario scenario = grid.at(run);
+    if (floors[run] != scenario.floors
+        || elevators[run] != scenario.elevators
+        || patterns[run] != scenario.pattern
+        || dispatches[run] != scenario.dispatch
+        || rates[run] != scenario.rate
+        || seeds[run] != scenario.seed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool sim::SweepFile::resume(const char *path, const SweepGrid &grid) {
+  if (!map(path, true, 0)) {
+    return false;
+  }
+  if (!valid()) {
+    close();
+    return false;
+  }
+  size_ = header().runs;
+  layout(size_, offsets_);
+  if (!matches(grid)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool sim::SweepFile::sync() {
+  if (map_ == NULL || !writable_) {
+    return true;
+  }
+  return msync(map_, map_size_, MS_SYNC) == 0;
+}
+
+bool sim::SweepFile::close() {
+  if (map_ == NULL) {
+    return true;
+  }
+  bool ok = sync();
+  munmap(map_, map_size_);
+  map_ = NULL;
+  map_size_ = 0;
+  writable_ = false;
+  size_ = 0;
+  memset(offsets_, 0, sizeof(offsets_));
+  return ok;
+}
+
+size_t sim::SweepFile::done_count() const {
+  const uint8_t *done = column<uint8_t>(COLUMN_DONE);
+  size_t count = 0;
+  for (size_t run = 0; run < size_; ++run) {
+    count += (done[run] != 0);
+  }
+  return count;
+}
+
+void sim::SweepFile::record(size_t run, const RunResult &result,
+    const LatencyStats &latency) {
+  assert(writable_ && run < size_);
+  mutable_column<uint8_t>(COLUMN_COMPLETED)[run] = result.completed;
+  mutable_column<uint64_t>(COLUMN_TICKS)[run] = result.ticks;
+  mutable_column<uint64_t>(COLUMN_INSERTED)[run] = result.inserted;
+  mutable_column<uint64_t>(COLUMN_DELIVERED)[run] = latency.travel.count();
+  mutable_column<double>(COLUMN_WAIT_MEAN)[run] = latency.wait.mean();
+  mutable_column<uint64_t>(COLUMN_WAIT_P99)[run] =
+    latency.wait.percentile(99);
+  mutable_column<uint64_t>(COLUMN_WAIT_MAX)[run] = latency.wait.max();
+  mutable_column<double>(COLUMN_TRAVEL_MEAN)[run] = latency.travel.mean();
+  mutable_column<uint64_t>(COLUMN_TRAVEL_P99)[run] =
+    latency.travel.percentile(99);
+  mutable_column<uint64_t>(COLUMN_TRAVEL_MAX)[run] = latency.travel.max();
+  // Only marked done once everything else is in place. The page cache
+  // outlives the process, so a kill can't leave the results half written
+  // as long as the compiler keeps the stores in order.
+  std::atomic_signal_fence(std::memory_order_release);
+  mutable_column<uint8_t>(COLUMN_DONE)[run] = 1;
+}
+
+void sim::SweepFile::clear(size_t run) {
+  assert(writable_ && run < size_);
+  mutable_column<uint8_t>(COLUMN_DONE)[run] = 0;
+}
+
+sim::SweepRunner::SweepRunner(size_t threads/*=0*/)
+  : pool_(threads),
+    schedulers_(pool_.size()) { }
+
+bool sim::SweepRunner::run(const SweepGrid &grid, SweepFile &file,
+    const progress_t &progress/*=progress_t()*/, size_t checkpoint/*=0*/) {
+  if (checkpoint == 0) {
+    checkpoint = CHECKPOINT_PER_THREAD * pool_.size();
+  }
+  std::vector<size_t> pending;
+  for (size_t run = 0; run < file.size(); ++run) {
+    if (!file.done(run)) {
+      pending.push_back(run);
+    }
+  }
+  size_t done = file.size() - pending.size();
+
+  for (size_t begin = 0; begin < pending.size(); begin += checkpoint) {
+    size_t count = std::min(checkpoint, pending.size() - begin);
+    const size_t *runs = pending.data() + begin;
+    pool_.parallel_for_slots(count,
+        [this, &grid, &file, runs](size_t slot, size_t first, size_t last) {
+          LatencyStats latency;
+          for (size_t i = first; i < last; ++i) {
+            Scenario scenario = grid.at(runs[i]);
+            latency.wait.clear();
+            latency.travel.clear();
+            RunResult result = run_scenario(
+                schedulers_.get(slot, scenario), scenario, &latency);
+            file.record(runs[i], result, latency);
+          }
+        });
+    if (!file.sync()) {
+      return false;
+    }
+    done += count;
+    if (progress) {
+      progress(done, file.size());
+    }
+  }
+  return true;
+}
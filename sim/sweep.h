@@ -0,0 +1,266 @@
+#ifndef _sim_sweep_h_
+#define _sim_sweep_h_
+
+#include <assert.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "sim/batch.h"
+
+namespace sim {
+
+  /**
+   * A grid of scenarios: every combination of the values along each axis,
+   * each run with several seeds. An empty axis keeps the value from 'base',
+   * which also supplies the settings that aren't swept.
+   *
+   * Runs are numbered with the seed varying fastest and the floor count
+   * slowest, so neighbouring runs usually share a building.
+   */
+  class SweepGrid {
+   public:
+    SweepGrid() : seeds(1) { }
+
+    Scenario base;
+
+    std::vector<floor_t> floors;
+    std::vector<size_t> elevators;
+    std::vector<Pattern> patterns;
+    std::vector<double> rates;
+    std::vector<Dispatch> dispatches;
+
+    // Seeds to run at each point, counting up from base.seed.
+    size_t seeds;
+
+    /**
+     * Returns the total number of runs in the grid.
+     */
+    size_t size() const;
+
+    /**
+     * Returns the scenario for the provided run, where run < size().
+     */
+    Scenario at(size_t run) const;
+  };
+
+  /**
+   * The columns of a sweep results file. The first few hold each run's
+   * parameters, and are filled in when the file is created. The rest hold its
+   * results once COLUMN_DONE is set.
+   */
+  enum SweepColumn {
+    COLUMN_FLOORS, // uint32
+    COLUMN_ELEVATORS, // uint32
+    COLUMN_PATTERN, // uint8, a Pattern
+    COLUMN_DISPATCH, // uint8, a Dispatch
+    COLUMN_RATE, // double
+    COLUMN_SEED, // uint64
+    COLUMN_DONE, // uint8, 1 once the run's results are written
+    COLUMN_COMPLETED, // uint8, RunResult::completed
+    COLUMN_TICKS, // uint64
+    COLUMN_INSERTED, // uint64
+    COLUMN_DELIVERED, // uint64, requests dropped off
+    COLUMN_WAIT_MEAN, // double
+    COLUMN_WAIT_P99, // uint64
+    COLUMN_WAIT_MAX, // uint64
+    COLUMN_TRAVEL_MEAN, // double
+    COLUMN_TRAVEL_P99, // uint64
+    COLUMN_TRAVEL_MAX, // uint64
+    COLUMN_COUNT
+  };
+
+  /**
+   * The value types of sweep columns, as recorded in the file.
+   */
+  enum SweepType {
+    SWEEP_UINT8 = 1,
+    SWEEP_UINT32 = 2,
+    SWEEP_UINT64 = 3,
+    SWEEP_DOUBLE = 4
+  };
+
+  /**
+   * Returns the name of the provided column, as used in the file and in CSV
+   * headers.
+   */
+  const char *string(SweepColumn column);
+
+  /**
+   * The start of a sweep results file. It's followed by COLUMN_COUNT
+   * SweepColumnInfos, then each column as one array of 'runs' values, in
+   * native byte order and starting on an 8 byte boundary. This lets analysis
+   * tools map the columns straight into arrays.
+   */
+  class SweepHeader {
+   public:
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t runs;
+
+    // The settings shared by every run.
+    uint64_t requests;
+    uint64_t max_ticks;
+    uint64_t capacity;
+    uint32_t passengers;
+    uint32_t reserved;
+  };
+
+  class SweepColumnInfo {
+   public:
+    char name[16];
+    uint32_t type; // A SweepType
+    uint32_t width; // Bytes per value
+    uint64_t offset; // From the start of the file
+  };
+
+  /**
+   * A sweep results file, mapped into memory. Every run has a fixed place in
+   * each column, so the file is created at its full size, and results may be
+   * written in any order and from any thread. A run's COLUMN_DONE flag is set
+   * after its results, so the file doubles as the sweep's checkpoint: a sweep
+   * which was killed can be resumed by reopening its file and running
+   * whatever isn't done.
+   */
+  class SweepFile {
+   public:
+    SweepFile();
+    virtual ~SweepFile();
+
+    /**
+     * Creates a results file for the provided grid with no runs done,
+     * replacing any existing file. Returns false if it couldn't be created.
+     */
+    bool create(const char *path, const SweepGrid &grid);
+
+    /**
+     * Reopens an existing results file for the provided grid, so that the
+     * runs which aren't done can be added. Returns false if it couldn't be
+     * opened, or was created for a different grid.
+     */
+    bool resume(const char *path, const SweepGrid &grid);
+
+    /**
+     * Opens an existing results file read-only. Returns false if it couldn't
+     * be opened or isn't a valid results file.
+     */
+    bool open(const char *path);
+
+    /**
+     * Writes out any changes and closes the file.
+     */
+    bool close();
+
+    /**
+     * Flushes the results written so far to disk.
+     */
+    bool sync();
+
+    const SweepHeader &header() const {
+      return *(const SweepHeader*)map_;
+    }
+
+    /**
+     * Returns the number of runs in the file.
+     */
+    size_t size() const {
+      return size_;
+    }
+
+    /**
+     * Returns the values of a column, which must be of type T.
+     */
+    template <typename T>
+    const T *column(SweepColumn column) const {
+      assert(sizeof(T) == width(column));
+      return (const T*)((const char*)map_ + offsets_[column]);
+    }
+
+    bool done(size_t run) const {
+      return column<uint8_t>(COLUMN_DONE)[run] != 0;
+    }
+
+    /**
+     * Returns the number of runs which are done.
+     */
+    size_t done_count() const;
+
+    /**
+     * Writes a run's results and marks it as done. Different runs may be
+     * recorded from different threads at once.
+     */
+    void record(size_t run, const RunResult &result,
+        const LatencyStats &latency);
+
+    /**
+     * Marks a run as not done, so that it's run again when resumed.
+     */
+    void clear(size_t run);
+
+    /**
+     * Returns the byte width of a column's values.
+     */
+    static size_t width(SweepColumn column);
+
+   private:
+    bool map(const char *path, bool writable, size_t size);
+    bool valid() const;
+    bool matches(const SweepGrid &grid) const;
+
+    template <typename T>
+    T *mutable_column(SweepColumn column) {
+      assert(sizeof(T) == width(column));
+      return (T*)((char*)map_ + offsets_[column]);
+    }
+
+    void *map_;
+    size_t map_size_;
+    bool writable_;
+    size_t size_;
+    uint64_t offsets_[COLUMN_COUNT];
+  };
+
+  /**
+   * Runs the unfinished runs of a sweep across a pool of threads, recording
+   * each one in a SweepFile as it finishes.
+   */
+  class SweepRunner {
+   public:
+    /**
+     * Called after each checkpoint with the number of runs done so far, and
+     * the total.
+     */
+    typedef std::function<void(size_t done, size_t total)> progress_t;
+
+    /**
+     * Creates a runner with the provided number of threads. A value of 0 uses
+     * one thread per hardware core.
+     */
+    SweepRunner(size_t threads = 0);
+    virtual ~SweepRunner() { }
+
+    /**
+     * Runs every run of 'grid' which isn't done in 'file', syncing the file
+     * to disk after every 'checkpoint' runs, or after each round of a few
+     * runs per thread if it's 0. Returns false if the file couldn't be
+     * synced.
+     */
+    bool run(const SweepGrid &grid, SweepFile &file,
+        const progress_t &progress = progress_t(), size_t checkpoint = 0);
+
+    /**
+     * Returns the per-thread Schedulers, which are reused by runs in the
+     * same building.
+     */
+    const SchedulerCache &schedulers() const {
+      return schedulers_;
+    }
+
+   private:
+    ThreadPool pool_;
+    SchedulerCache schedulers_;
+  };
+}
+
+#endif /* _sim_sweep_h_ */
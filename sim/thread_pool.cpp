@@ -0,0 +1,141 @@
+#include "sim/thread_pool.h"
+
+#include <algorithm>
+
+sim::ThreadPool::ThreadPool(size_t threads/*=0*/)
+  : task_(NULL),
+    grain_(1),
+    generation_(0),
+    active_(0),
+    stop_(false) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  slots_ = std::vector<Slot>(threads);
+  // Slot 0 belongs to the thread calling parallel_for().
+  for (size_t i = 1; i < threads; ++i) {
+    workers_.push_back(std::thread(&ThreadPool::worker, this, i));
+  }
+}
+
+sim::ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (std::thread &thread : workers_) {
+    thread.join();
+  }
+}
+
+size_t sim::ThreadPool::size() const {
+  return slots_.size();
+}
+
+void sim::ThreadPool::parallel_for(size_t count, const task_t &task,
+    size_t grain/*=1*/) {
+  parallel_for_slots(count,
+      [&task](size_t slot, size_t begin, size_t end) { task(begin, end); },
+      grain);
+}
+
+void sim::ThreadPool::parallel_for_slots(size_t count,
+    const slot_task_t &task, size_t grain/*=1*/) {
+  grain = std::max<size_t>(grain, 1);
+  if (workers_.empty() || count <= grain) {
+    // Not worth waking anyone up.
+    if (count > 0) {
+      task(0, 0, count);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  grain_ = grain;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    std::lock_guard<std::mutex> slot_lock(slots_[i].mutex);
+    slots_[i].begin = count * i / slots_.size();
+    slots_[i].end = count * (i + 1) / slots_.size();
+  }
+  active_ = workers_.size();
+  ++generation_;
+  lock.unlock();
+  start_cv_.notify_all();
+
+  run_slots(0);
+
+  lock.lock();
+  done_cv_.wait(lock, [this]() { return active_ == 0; });
+  task_ = NULL;
+}
+
+void sim::ThreadPool::worker(size_t slot) {
+  size_t generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock,
+          [this, generation]() { return stop_ || generation_ != generation; });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+    }
+
+    run_slots(slot);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--active_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void sim::ThreadPool::run_slots(size_t slot) {
+  size_t begin, end;
+  for (;;) {
+    if (take(slot, begin, end)) {
+      (*task_)(slot, begin, end);
+    } else if (!steal(slot)) {
+      // Nothing left anywhere.
+      return;
+    }
+  }
+}
+
+bool sim::ThreadPool::take(size_t slot, size_t &begin, size_t &end) {
+  Slot &own = slots_[slot];
+  std::lock_guard<std::mutex> lock(own.mutex);
+  if (own.begin == own.end) {
+    return false;
+  }
+  begin = own.begin;
+  end = std::min(own.begin + grain_, own.end);
+  own.begin = end;
+  return true;
+}
+
+bool sim::ThreadPool::steal(size_t slot) {
+  for (size_t i = 1; i < slots_.size(); ++i) {
+    Slot &victim = slots_[(slot + i) % slots_.size()];
+    size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.begin == victim.end) {
+        continue;
+      }
+      // Take the back half, leaving the front for the victim to continue on.
+      begin = victim.begin + (victim.end - victim.begin) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+    Slot &own = slots_[slot];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
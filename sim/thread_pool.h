@@ -0,0 +1,91 @@
+#ifndef _sim_thread_pool_h_
+#define _sim_thread_pool_h_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+  /**
+   * A persistent pool of worker threads which runs parallel loops. Each
+   * parallel_for() splits its index range evenly across the threads. Threads
+   * which run out of work steal half of the remaining range from another
+   * thread, so uneven per-index costs still keep every thread busy.
+   *
+   * The thread calling parallel_for() takes part in the work, so a pool of N
+   * threads starts N-1 workers.
+   */
+  class ThreadPool {
+   public:
+    /**
+     * Runs the indexes in [begin, end).
+     */
+    typedef std::function<void(size_t begin, size_t end)> task_t;
+
+    /**
+     * Runs the indexes in [begin, end) on the thread numbered 'slot', where
+     * slot < size(). No two tasks in a loop run on the same slot at once, so
+     * tasks may keep per-thread state indexed by slot without locking.
+     */
+    typedef std::function<void(size_t slot, size_t begin, size_t end)>
+      slot_task_t;
+
+    /**
+     * Creates a pool which runs loops across the provided number of threads.
+     * A value of 0 uses one thread per hardware core.
+     */
+    ThreadPool(size_t threads = 0);
+    virtual ~ThreadPool();
+
+    /**
+     * Returns the number of threads which run loops, including the caller.
+     */
+    size_t size() const;
+
+    /**
+     * Runs 'task' over every index in [0, count), returning once it has
+     * finished. Work is taken and stolen in chunks of at most 'grain'
+     * indexes. This may only be called from one thread at a time.
+     */
+    void parallel_for(size_t count, const task_t &task, size_t grain = 1);
+
+    /**
+     * As above, but also passes each task the slot of the thread running it.
+     */
+    void parallel_for_slots(size_t count, const slot_task_t &task,
+        size_t grain = 1);
+
+   private:
+    /**
+     * The remaining range of indexes held by one thread.
+     */
+    class Slot {
+     public:
+      Slot() : begin(0), end(0) { }
+
+      std::mutex mutex;
+      size_t begin, end;
+    };
+
+    void worker(size_t slot);
+    void run_slots(size_t slot);
+    bool take(size_t slot, size_t &begin, size_t &end);
+    bool steal(size_t slot);
+
+    std::vector<std::thread> workers_;
+    std::vector<Slot> slots_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_, done_cv_;
+    const slot_task_t *task_;
+    size_t grain_;
+    size_t generation_;
+    size_t active_;
+    bool stop_;
+  };
+}
+
+#endif /* _sim_thread_pool_h_ */
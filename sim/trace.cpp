@@ -0,0 +1,217 @@
+#include "sim/trace.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char MAGIC[8] = {'E', 'L', 'E', 'V', 'T', 'R', 'C', '\0'};
+  const uint32_t VERSION = 1;
+
+  // Records buffered by a TraceWriter between writes.
+  const size_t BUFFER_RECORDS = 4096;
+}
+
+sim::TraceWriter::TraceWriter()
+  : file_(NULL) {
+  buffer_.reserve(BUFFER_RECORDS);
+}
+
+sim::TraceWriter::~TraceWriter() {
+  close();
+}
+
+bool sim::TraceWriter::open(const char *path, floor_t floors,
+    size_t elevators) {
+  close();
+  file_ = fopen(path, "wb");
+  if (file_ == NULL) {
+    return false;
+  }
+  TraceHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.record_size = sizeof(TraceRecord);
+  header.floors = floors;
+  header.elevators = elevators;
+  if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool sim::TraceWriter::close() {
+  if (file_ == NULL) {
+    return true;
+  }
+  bool ok = flush();
+  ok = (fclose(file_) == 0) && ok;
+  file_ = NULL;
+  return ok;
+}
+
+bool sim::TraceWriter::flush() {
+  bool ok = true;
+  if (file_ != NULL && !buffer_.empty()) {
+    ok = fwrite(buffer_.data(), sizeof(TraceRecord), buffer_.size(), file_)
+      == buffer_.size();
+  }
+  buffer_.clear();
+  return ok;
+}
+
+sim::TraceReader::TraceReader()
+  : map_(NULL), map_size_(0), header_(NULL), records_(NULL), size_(0) { }
+
+sim::TraceReader::~TraceReader() {
+  close();
+}
+
+bool sim::TraceReader::open(const char *path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(TraceHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  map_ = map;
+  map_size_ = st.st_size;
+
+  header_ = (const TraceHeader*)map_;
+  if (memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0
+      || header_->version != VERSION
+      || header_->record_size != sizeof(TraceRecord)) {
+    close();
+    return false;
+  }
+  records_ = (const TraceRecord*)(header_ + 1);
+  // Ignore any partial record at the end, eg from a crashed writer.
+  size_ = (map_size_ - sizeof(TraceHeader)) / sizeof(TraceRecord);
+  // Records are read in order, so let the kernel read ahead.
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void sim::TraceReader::close() {
+  if (map_ != NULL) {
+    munmap(map_, map_size_);
+  }
+  map_ = NULL;
+  map_size_ = 0;
+  header_ = NULL;
+  records_ = NULL;
+  size_ = 0;
+}
+
+size_t sim::TraceReader::find(uint64_t tick) const {
+  size_t low = 0, high = size_;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (records_[mid].tick < tick) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+sim::TraceState::TraceState(floor_t floors, size_t elevators)
+  : tick(0),
+    elevators(elevators, Elevator(0, floors)),
+    up_requests(floors, FloorSet(floors)),
+    down_requests(floors, FloorSet(floors)),
+    up_accepted(floors),
+    down_accepted(floors) { }
+
+bool sim::TraceState::apply(const TraceRecord &record) {
+  if (record.tick < tick) {
+    return false;
+  }
+  tick = record.tick;
+  floor_t floors = up_requests.size();
+
+  switch (record.type) {
+    case TRACE_REQUEST:
+      if (record.a >= floors || record.b >= floors) {
+        return false;
+      }
+      if (record.a < record.b) {
+        up_requests[record.a].insert(record.b);
+      } else if (record.a > record.b) {
+        down_requests[record.a].insert(record.b);
+      } else {
+        return false;
+      }
+      return true;
+
+    case TRACE_PICKUP:
+      if (record.elevator >= elevators.size() || record.a >= floors
+          || !elevators[record.elevator].insert_request(
+              record.a, Direction(record.b))) {
+        return false;
+      }
+      if (record.b == Direction::UP) {
+        up_accepted.insert(record.a);
+      } else {
+        down_accepted.insert(record.a);
+      }
+      return true;
+
+    case TRACE_DROPOFF: {
+      if (record.elevator >= elevators.size() || record.a >= floors) {
+        return false;
+      }
+      Elevator &elevator = elevators[record.elevator];
+      // The whole group at the elevator's floor is handed over at once.
+      floor_t pickup_floor = elevator.floor();
+      if (record.b == Direction::UP) {
+        up_requests[pickup_floor].erase(record.a);
+        up_accepted.erase(pickup_floor);
+      } else {
+        down_requests[pickup_floor].erase(record.a);
+        down_accepted.erase(pickup_floor);
+      }
+      return elevator.insert_request(record.a, Direction(record.b));
+    }
+
+    case TRACE_ACTION: {
+      if (record.elevator >= elevators.size()) {
+        return false;
+      }
+      Elevator &elevator = elevators[record.elevator];
+      Action action = elevator.tick();
+      return action == Action(record.b) && elevator.floor() == record.a;
+    }
+
+    case TRACE_SKIP:
+      for (Elevator &elevator : elevators) {
+        if (elevator.request_count() == 0) {
+          continue;
+        }
+        if (elevator.distance_to_next_request() < record.a) {
+          return false;
+        }
+        elevator.skip_floors(record.a);
+      }
+      return true;
+
+    case TRACE_HASH:
+      // Only useful for comparing traces.
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,163 @@
+#ifndef _sim_trace_h_
+#define _sim_trace_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "sim/elevator.h"
+
+namespace sim {
+
+  /**
+   * The kinds of events which are recorded in a trace.
+   */
+  enum TraceType {
+    TRACE_REQUEST = 1, // Request inserted: a=source, b=dest
+    TRACE_PICKUP = 2, // Pickup accepted: elevator, a=floor, b=Direction
+    TRACE_DROPOFF = 3, // Dropoff handed over: elevator, a=floor, b=Direction
+    TRACE_ACTION = 4, // Non-IDLE Action: elevator, a=floor after, b=Action
+    TRACE_SKIP = 5, // Travel-only ticks skipped: a=tick count
+    TRACE_HASH = 6 // Scheduler::state_hash() at the end of the tick: a=low
+                   // 32 bits, b=high 32 bits
+  };
+
+  /**
+   * One fixed-width trace record. Records are appended in the order that the
+   * events happened, so they're also sorted by tick.
+   */
+  class TraceRecord {
+   public:
+    uint64_t tick;
+    uint32_t elevator;
+    uint32_t a, b;
+    uint8_t type;
+    uint8_t reserved[3];
+  };
+
+  /**
+   * The start of a trace file, followed by the records.
+   */
+  class TraceHeader {
+   public:
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t floors;
+    uint64_t elevators;
+  };
+
+  /**
+   * Appends trace records to a file. Records are buffered, and written out
+   * when the buffer fills up or the trace is closed.
+   */
+  class TraceWriter {
+   public:
+    TraceWriter();
+    virtual ~TraceWriter();
+
+    /**
+     * Creates a trace file for a Scheduler with the provided dimensions,
+     * replacing any existing file. Returns false if it couldn't be created.
+     */
+    bool open(const char *path, floor_t floors, size_t elevators);
+
+    /**
+     * Writes out any buffered records and closes the file.
+     */
+    bool close();
+
+    /**
+     * Appends a record to the trace.
+     */
+    void record(TraceType type, uint64_t tick, uint32_t elevator,
+        uint32_t a, uint32_t b) {
+      if (buffer_.size() == buffer_.capacity()) {
+        flush();
+      }
+      TraceRecord r = {tick, elevator, a, b, uint8_t(type), {0, 0, 0}};
+      buffer_.push_back(r);
+    }
+
+   private:
+    bool flush();
+
+    FILE *file_;
+    std::vector<TraceRecord> buffer_;
+  };
+
+  /**
+   * Provides access to a trace file's records without reading it into
+   * memory, by mapping the file.
+   */
+  class TraceReader {
+   public:
+    TraceReader();
+    virtual ~TraceReader();
+
+    /**
+     * Maps the provided trace file. Returns false if it couldn't be opened or
+     * isn't a valid trace.
+     */
+    bool open(const char *path);
+    void close();
+
+    const TraceHeader &header() const {
+      return *header_;
+    }
+
+    /**
+     * Returns the number of records in the trace.
+     */
+    size_t size() const {
+      return size_;
+    }
+
+    const TraceRecord &operator[](size_t index) const {
+      return records_[index];
+    }
+
+    /**
+     * Returns the index of the first record at or after the provided tick,
+     * or size() if there isn't one.
+     */
+    size_t find(uint64_t tick) const;
+
+   private:
+    void *map_;
+    size_t map_size_;
+    const TraceHeader *header_;
+    const TraceRecord *records_;
+    size_t size_;
+  };
+
+  /**
+   * The state of a simulation, rebuilt by applying trace records in order.
+   * Elevators are replayed using the Elevator class itself, so each recorded
+   * action is checked against what the Elevator would have done.
+   */
+  class TraceState {
+   public:
+    TraceState(floor_t floors, size_t elevators);
+    virtual ~TraceState() { }
+
+    /**
+     * Applies the next record. Returns false if the record is inconsistent
+     * with the state so far.
+     */
+    bool apply(const TraceRecord &record);
+
+    // The tick of the last record applied.
+    uint64_t tick;
+
+    std::vector<Elevator> elevators;
+
+    // Destinations which are waiting for pickup, by pickup floor.
+    std::vector<FloorSet> up_requests, down_requests;
+
+    // Pickup floors which have been accepted by an elevator.
+    FloorSet up_accepted, down_accepted;
+  };
+}
+
+#endif /* _sim_trace_h_ */
@@ -0,0 +1,185 @@
+#include "sim/traffic.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+  // Largest mean arrivals for one part of a tick. e^-32 is still well within
+  // the range of a double, so the table's probabilities don't underflow.
+  const double PART_MEAN = 32;
+
+  // Percent of peak trips which go to or from the lobby. The rest are
+  // inter-floor trips.
+  const uint64_t PEAK_PERCENT = 90;
+
+  /**
+   * Returns e^-x for 0 <= x <= PART_MEAN. This only uses basic arithmetic,
+   * which IEEE 754 defines exactly, so the table comes out the same
+   * everywhere, unlike with the platform's exp().
+   */
+  double exp_negative(double x) {
+    // e^-x = (e^(-x/2^n))^(2^n), with the inner term from its Taylor series.
+    size_t halvings = 0;
+    while (x > 1.0 / 1024) {
+      x /= 2;
+      ++halvings;
+    }
+    double term = 1, sum = 1;
+    for (int k = 1; k <= 8; ++k) {
+      term *= -x / k;
+      sum += term;
+    }
+    for (; halvings > 0; --halvings) {
+      sum *= sum;
+    }
+    return sum;
+  }
+
+  uint64_t scale(double probability) {
+    if (probability >= 1) {
+      return UINT64_MAX;
+    }
+    return uint64_t(probability * 18446744073709551616.0 /* 2^64 */);
+  }
+}
+
+const char *sim::string(Pattern pattern) {
+  switch (pattern) {
+    case INTER_FLOOR: return "inter-floor";
+    case UP_PEAK: return "up-peak";
+    case DOWN_PEAK: return "down-peak";
+    case LUNCH: return "lunch";
+  }
+  return "?";
+}
+
+bool sim::parse_pattern(const char *name, Pattern &pattern) {
+  static const Pattern ALL[] = {INTER_FLOOR, UP_PEAK, DOWN_PEAK, LUNCH};
+  for (Pattern candidate : ALL) {
+    if (strcmp(name, string(candidate)) == 0) {
+      pattern = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+sim::TrafficGenerator::TrafficGenerator(floor_t floors, Pattern pattern,
+    double rate, uint64_t seed, size_t requests/*=0*/)
+  : floors_(floors),
+    pattern_(pattern),
+    seed_(seed),
+    parts_(0),
+    next_tick_(1),
+    pending_begin_(0),
+    remaining_(requests),
+    unlimited_(requests == 0) {
+  assert(floors >= 2);
+  if (!(rate > 0)) {
+    // No arrivals.
+    return;
+  }
+  parts_ = size_t(std::ceil(rate / PART_MEAN));
+  double mean = rate / parts_;
+
+  /* Tabulate the Poisson CDF until the rest of the tail is too small to
+   * matter. The last entry catches everything, so lookups always stop. */
+  double probability = exp_negative(mean);
+  double cumulative = probability;
+  for (size_t k = 0; cumulative < 1; ++k) {
+    if (k > mean && probability < 1e-18) {
+      break;
+    }
+    cdf_.push_back(scale(cumulative));
+    probability *= mean / (k + 1);
+    cumulative += probability;
+  }
+  cdf_.push_back(UINT64_MAX);
+}
+
+size_t sim::TrafficGenerator::generate(size_t tick,
+    std::vector<Request> &out) const {
+  RandomStream stream = seed_.split(tick);
+  size_t count = arrivals(stream);
+  size_t begin = out.size();
+  out.resize(begin + count);
+  for (size_t i = begin; i < out.size(); ++i) {
+    out[i].tick = tick;
+    trip(stream, out[i]);
+  }
+  return count;
+}
+
+size_t sim::TrafficGenerator::read(Request *out, size_t max) {
+  if (parts_ == 0) {
+    return 0;
+  }
+  size_t count = 0;
+  while (count < max && (unlimited_ || remaining_ > 0)) {
+    if (pending_begin_ == pending_.size()) {
+      pending_.clear();
+      pending_begin_ = 0;
+      generate(next_tick_++, pending_);
+      continue;
+    }
+    size_t take = std::min(max - count, pending_.size() - pending_begin_);
+    if (!unlimited_) {
+      take = std::min(take, remaining_);
+      remaining_ -= take;
+    }
+    memcpy(out + count, &pending_[pending_begin_], take * sizeof(Request));
+    pending_begin_ += take;
+    count += take;
+  }
+  return count;
+}
+
+size_t sim::TrafficGenerator::arrivals(RandomStream &stream) const {
+  size_t total = 0;
+  size_t last = cdf_.size() - 1;
+  for (size_t part = 0; part < parts_; ++part) {
+    uint64_t value = stream.next();
+    size_t k = 0;
+    while (k < last && value >= cdf_[k]) {
+      ++k;
+    }
+    total += k;
+  }
+  return total;
+}
+
+void sim::TrafficGenerator::trip(RandomStream &stream,
+    Request &request) const {
+  uint64_t roll = (pattern_ == INTER_FLOOR) ? 100 : stream.below(100);
+  bool from_lobby = false, to_lobby = false;
+  switch (pattern_) {
+    case INTER_FLOOR:
+      break;
+    case UP_PEAK:
+      from_lobby = roll < PEAK_PERCENT;
+      break;
+    case DOWN_PEAK:
+      to_lobby = roll < PEAK_PERCENT;
+      break;
+    case LUNCH:
+      from_lobby = roll < PEAK_PERCENT / 2;
+      to_lobby = !from_lobby && roll < PEAK_PERCENT;
+      break;
+  }
+  if (from_lobby) {
+    request.source = 0;
+    request.dest = 1 + stream.below(floors_ - 1);
+  } else if (to_lobby) {
+    request.source = 1 + stream.below(floors_ - 1);
+    request.dest = 0;
+  } else {
+    request.source = stream.below(floors_);
+    // Avoid having dest == source by skipping over the source floor.
+    request.dest = stream.below(floors_ - 1);
+    if (request.dest >= request.source) {
+      ++request.dest;
+    }
+  }
+}
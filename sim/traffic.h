@@ -0,0 +1,107 @@
+#ifndef _sim_traffic_h_
+#define _sim_traffic_h_
+
+#include <stdint.h>
+#include <vector>
+
+#include "sim/random.h"
+#include "sim/workload.h"
+
+namespace sim {
+
+  /**
+   * The standard traffic patterns of an office building, where floor 0 is
+   * the lobby.
+   */
+  enum Pattern {
+    // Trips between random pairs of floors.
+    INTER_FLOOR,
+
+    // The morning rush: most trips are from the lobby to the floors above.
+    UP_PEAK,
+
+    // The evening rush: most trips are from the floors above to the lobby.
+    DOWN_PEAK,
+
+    // Lunchtime: most trips are to or from the lobby, in equal measure.
+    LUNCH
+  };
+
+  /**
+   * Returns a short name for the provided Pattern, as accepted by
+   * parse_pattern().
+   */
+  const char *string(Pattern pattern);
+
+  /**
+   * Sets 'pattern' to the Pattern with the provided short name
+   * ("inter-floor", "up-peak", "down-peak" or "lunch"). Returns false if the
+   * name isn't recognized.
+   */
+  bool parse_pattern(const char *name, Pattern &pattern);
+
+  /**
+   * Generates random requests for a traffic pattern, arriving as a Poisson
+   * process at an average rate per tick. Every request is valid, with a
+   * distinct source and destination.
+   *
+   * The requests for each tick come from their own RandomStream, split from
+   * the seed by tick number, so a tick's requests only depend on the seed
+   * and the tick. They come out the same on every machine, and ranges of
+   * ticks may be generated on separate threads and joined. The arrival
+   * counts are drawn from a table which is worked out once, so each tick
+   * costs one random value plus a few for each request.
+   */
+  class TrafficGenerator : public RequestSource {
+   public:
+    /**
+     * Creates a generator for a building with the provided number of floors,
+     * which must be at least 2. read() returns 'requests' requests in total,
+     * starting from tick 1, or runs forever if it's 0.
+     */
+    TrafficGenerator(floor_t floors, Pattern pattern, double rate,
+        uint64_t seed, size_t requests = 0);
+    virtual ~TrafficGenerator() { }
+
+    /**
+     * Appends the requests arriving at the provided tick to 'out', and
+     * returns the number appended. This doesn't change the generator, so it
+     * may be called from several threads at once.
+     */
+    size_t generate(size_t tick, std::vector<Request> &out) const;
+
+    /**
+     * Reads the next requests in tick order, as with any RequestSource.
+     */
+    size_t read(Request *out, size_t max);
+
+   private:
+    size_t arrivals(RandomStream &stream) const;
+    void trip(RandomStream &stream, Request &request) const;
+
+    floor_t floors_;
+    Pattern pattern_;
+    RandomStream seed_;
+
+    /**
+     * Arrivals are drawn 'parts_' times per tick and summed, each from a
+     * Poisson distribution with a small enough mean that its probabilities
+     * don't underflow. 'cdf_[k]' is the chance of at most k arrivals in a
+     * part, scaled to the range of a uint64_t.
+     */
+    size_t parts_;
+    std::vector<uint64_t> cdf_;
+
+    /**
+     * Progress through read(): the next tick to generate, the tick being
+     * returned, and the requests left to return in total.
+     */
+    size_t next_tick_;
+    std::vector<Request> pending_;
+    size_t pending_begin_;
+    size_t remaining_;
+    bool unlimited_;
+  };
+}
+
+#endif /* _sim_traffic_h_ */
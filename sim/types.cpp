@@ -1,4 +1,157 @@
 #include "sim/types.h"
+#include "sim/arena.h"
+
+#include <algorithm>
+
+namespace {
+  uint64_t *allocate_words(std::size_t count, sim::Arena *arena) {
+    if (count == 0) {
+      return NULL;
+    }
+    if (arena != NULL) {
+      return arena->allocate_array<uint64_t>(count);
+    }
+    return new uint64_t[count];
+  }
+}
+
+sim::FloorSet::FloorSet(floor_t capacity/*=0*/, Arena *arena/*=NULL*/)
+  : words_(allocate_words((capacity + 63) / 64, arena)),
+    word_count_((capacity + 63) / 64),
+    count_(0),
+    arena_(arena) {
+  std::fill(words_, words_ + word_count_, 0);
+}
+
+sim::FloorSet::FloorSet(const FloorSet &other)
+  : words_(allocate_words(other.word_count_, NULL)),
+    word_count_(other.word_count_),
+    count_(other.count_),
+    arena_(NULL) {
+  std::copy(other.words_, other.words_ + word_count_, words_);
+}
+
+sim::FloorSet::FloorSet(FloorSet &&other) noexcept
+  : words_(other.words_),
+    word_count_(other.word_count_),
+    count_(other.count_),
+    arena_(other.arena_) {
+  other.words_ = NULL;
+  other.word_count_ = 0;
+  other.count_ = 0;
+  other.arena_ = NULL;
+}
+
+sim::FloorSet &sim::FloorSet::operator=(const FloorSet &other) {
+  if (this == &other) {
+    return *this;
+  }
+  if (word_count_ != other.word_count_) {
+    // Replace our storage, from the same place as before.
+    if (arena_ == NULL) {
+      delete[] words_;
+    }
+    words_ = allocate_words(other.word_count_, arena_);
+    word_count_ = other.word_count_;
+  }
+  std::copy(other.words_, other.words_ + word_count_, words_);
+  count_ = other.count_;
+  return *this;
+}
+
+sim::FloorSet &sim::FloorSet::operator=(FloorSet &&other) {
+  if (arena_ != other.arena_) {
+    // Keep our storage where it is.
+    return *this = other;
+  }
+  std::swap(words_, other.words_);
+  std::swap(word_count_, other.word_count_);
+  std::swap(count_, other.count_);
+  return *this;
+}
+
+sim::FloorSet::~FloorSet() {
+  if (arena_ == NULL) {
+    delete[] words_;
+  }
+}
+
+void sim::FloorSet::grow(std::size_t word_count) {
+  uint64_t *words = allocate_words(word_count, arena_);
+  std::copy(words_, words_ + word_count_, words);
+  std::fill(words + word_count_, words + word_count, 0);
+  if (arena_ == NULL) {
+    delete[] words_;
+  }
+  words_ = words;
+  word_count_ = word_count;
+}
+
+void sim::FloorSet::clear() {
+  if (count_ == 0) {
+    return;
+  }
+  std::fill(words_, words_ + word_count_, 0);
+  count_ = 0;
+}
+
+void sim::FloorSet::recount() {
+  count_ = 0;
+  for (std::size_t i = 0; i < word_count_; ++i) {
+    count_ += __builtin_popcountll(words_[i]);
+  }
+}
+
+sim::floor_t sim::FloorSet::next(floor_t floor) const {
+  std::size_t word = floor / 64;
+  if (word >= word_count_) {
+    return end_floor();
+  }
+  // Mask off any floors below the starting floor in the first word.
+  uint64_t bits = words_[word] & (~uint64_t(0) << (floor % 64));
+  while (bits == 0) {
+    if (++word == word_count_) {
+      return end_floor();
+    }
+    bits = words_[word];
+  }
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+sim::floor_t sim::FloorSet::previous(floor_t floor) const {
+  if (word_count_ == 0) {
+    return end_floor();
+  }
+  std::size_t word = floor / 64;
+  uint64_t bits;
+  if (word >= word_count_) {
+    word = word_count_ - 1;
+    bits = words_[word];
+  } else {
+    // Mask off any floors above the starting floor in the first word.
+    bits = words_[word] & (~uint64_t(0) >> (63 - floor % 64));
+  }
+  while (bits == 0) {
+    if (word-- == 0) {
+      return end_floor();
+    }
+    bits = words_[word];
+  }
+  return word * 64 + 63 - __builtin_clzll(bits);
+}
+
+std::size_t sim::FloorSet::count_below(floor_t floor) const {
+  std::size_t word = floor / 64;
+  if (word >= word_count_) {
+    return count_;
+  }
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < word; ++i) {
+    count += __builtin_popcountll(words_[i]);
+  }
+  uint64_t below = (uint64_t(1) << (floor % 64)) - 1;
+  return count + __builtin_popcountll(words_[word] & below);
+}
 
 const char *sim::string(Direction direction) {
   switch (direction) {
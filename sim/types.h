@@ -2,15 +2,183 @@
 #define _sim_types_h_
 
 #include <cstddef>
-#include <set>
+#include <stdint.h>
+#include <vector>
 
 namespace sim {
+  class Arena;
+
   /**
    * A floor index in a building. The lowest level in the building is always 0,
    * regardless of any user-facing labels for floors.
    */
   typedef std::size_t floor_t;
-  typedef std::set<floor_t> floor_set_t;
+
+  /**
+   * A set of floors, stored as a bitset with one bit per floor in the
+   * building. The capacity is fixed when the set is created, so insert() and
+   * erase() are a single bit operation with no allocation. Floors beyond the
+   * capacity are still accepted, but will grow the underlying storage.
+   *
+   * The bits may be stored in an Arena rather than on the heap, so that all
+   * of a Scheduler's sets share one block of memory. Copies of a set always
+   * have their own heap storage, so they may outlive the arena. Assigning
+   * to a set of the same capacity copies the bits into its existing storage,
+   * wherever that is.
+   *
+   * The lowest and highest floors in the set are found with count-trailing and
+   * count-leading zero instructions, one 64-floor word at a time.
+   */
+  class FloorSet {
+   public:
+    /**
+     * Iterates over the floors in the set in ascending order.
+     */
+    class const_iterator {
+     public:
+      const_iterator(const FloorSet *set, floor_t floor)
+        : set_(set), floor_(floor) { }
+
+      floor_t operator*() const {
+        return floor_;
+      }
+      const_iterator &operator++() {
+        floor_ = set_->next(floor_ + 1);
+        return *this;
+      }
+      bool operator==(const const_iterator &other) const {
+        return floor_ == other.floor_;
+      }
+      bool operator!=(const const_iterator &other) const {
+        return floor_ != other.floor_;
+      }
+
+     private:
+      const FloorSet *set_;
+      floor_t floor_;
+    };
+
+    /**
+     * Creates an empty set with room for floors [0, capacity). The storage
+     * comes from the provided arena, or from the heap if it's NULL.
+     */
+    explicit FloorSet(floor_t capacity = 0, Arena *arena = NULL);
+    FloorSet(const FloorSet &other);
+    FloorSet(FloorSet &&other) noexcept;
+    FloorSet &operator=(const FloorSet &other);
+    FloorSet &operator=(FloorSet &&other);
+    ~FloorSet();
+
+    /**
+     * Returns whether the set has no floors.
+     */
+    bool empty() const {
+      return count_ == 0;
+    }
+
+    /**
+     * Returns the number of floors in the set.
+     */
+    std::size_t size() const {
+      return count_;
+    }
+
+    /**
+     * Returns whether the provided floor is in the set.
+     */
+    bool contains(floor_t floor) const;
+
+    /**
+     * Adds the provided floor to the set. Returns true if the floor was added,
+     * or false if it was already present.
+     */
+    bool insert(floor_t floor);
+
+    /**
+     * Removes the provided floor from the set. Returns true if the floor was
+     * removed, or false if it wasn't present.
+     */
+    bool erase(floor_t floor);
+
+    /**
+     * Removes all floors from the set, keeping its capacity.
+     */
+    void clear();
+
+    /**
+     * Returns the lowest floor in the set. The set must not be empty.
+     */
+    floor_t first() const;
+
+    /**
+     * Returns the highest floor in the set. The set must not be empty.
+     */
+    floor_t last() const;
+
+    /**
+     * Returns the lowest floor in the set which is greater than or equal to
+     * 'floor', or end_floor() if there isn't one.
+     */
+    floor_t next(floor_t floor) const;
+
+    /**
+     * Returns the highest floor in the set which is less than or equal to
+     * 'floor', or end_floor() if there isn't one.
+     */
+    floor_t previous(floor_t floor) const;
+
+    /**
+     * Returns the number of floors in the set which are less than 'floor'.
+     * This is a popcount of each word below it.
+     */
+    std::size_t count_below(floor_t floor) const;
+
+    /**
+     * Returns the floor value used by end(): one past the highest floor which
+     * fits in the current storage.
+     */
+    floor_t end_floor() const {
+      return word_count_ * 64;
+    }
+
+    /**
+     * Recomputes size() after the storage has been overwritten in place, eg
+     * when restoring the Arena which holds it.
+     */
+    void recount();
+
+    const_iterator begin() const {
+      return const_iterator(this, next(0));
+    }
+    const_iterator end() const {
+      return const_iterator(this, end_floor());
+    }
+
+   private:
+    void grow(std::size_t word_count);
+
+    uint64_t *words_;
+    std::size_t word_count_;
+    std::size_t count_;
+
+    // Where 'words_' came from, or NULL if it's owned on the heap.
+    Arena *arena_;
+  };
+
+  typedef FloorSet floor_set_t;
+
+  /**
+   * A request to travel from a source floor to a destination floor, which
+   * arrives at the scheduler at a given tick.
+   */
+  class Request {
+   public:
+    Request(std::size_t tick = 0, floor_t source = 0, floor_t dest = 0)
+      : tick(tick), source(source), dest(dest) { }
+
+    std::size_t tick;
+    floor_t source, dest;
+  };
 
   /**
    * The direction that an elevator may move.
@@ -42,4 +210,58 @@ namespace sim {
   const char *string(Action action);
 }
 
+/* The FloorSet operations below are called for every request and every
+ * elevator tick, so they're kept inline. */
+
+inline bool sim::FloorSet::contains(floor_t floor) const {
+  std::size_t word = floor / 64;
+  return word < word_count_
+    && (words_[word] & (uint64_t(1) << (floor % 64))) != 0;
+}
+
+inline bool sim::FloorSet::insert(floor_t floor) {
+  std::size_t word = floor / 64;
+  if (word >= word_count_) {
+    // Outside of the building size we were given. Slow path.
+    grow(word + 1);
+  }
+  uint64_t bit = uint64_t(1) << (floor % 64);
+  if ((words_[word] & bit) != 0) {
+    return false;
+  }
+  words_[word] |= bit;
+  ++count_;
+  return true;
+}
+
+inline bool sim::FloorSet::erase(floor_t floor) {
+  std::size_t word = floor / 64;
+  if (word >= word_count_) {
+    return false;
+  }
+  uint64_t bit = uint64_t(1) << (floor % 64);
+  if ((words_[word] & bit) == 0) {
+    return false;
+  }
+  words_[word] &= ~bit;
+  --count_;
+  return true;
+}
+
+inline sim::floor_t sim::FloorSet::first() const {
+  std::size_t word = 0;
+  while (words_[word] == 0) {
+    ++word;
+  }
+  return word * 64 + __builtin_ctzll(words_[word]);
+}
+
+inline sim::floor_t sim::FloorSet::last() const {
+  std::size_t word = word_count_ - 1;
+  while (words_[word] == 0) {
+    --word;
+  }
+  return word * 64 + 63 - __builtin_clzll(words_[word]);
+}
+
 #endif /* _sim_types_h_ */
@@ -0,0 +1,281 @@
+#include "sim/workload.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char MAGIC[8] = {'E', 'L', 'E', 'V', 'R', 'E', 'Q', '\0'};
+  const uint32_t VERSION = 1;
+
+  /**
+   * The start of a packed request file.
+   */
+  class PackedHeader {
+   public:
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+  };
+
+  /**
+   * One request in a packed request file.
+   */
+  class PackedRequest {
+   public:
+    uint64_t tick;
+    uint32_t source, dest;
+  };
+
+  // Size of each read from a CSV file. Lines must be shorter than this.
+  const size_t CSV_CHUNK = 1024 * 1024;
+
+  // Parses an unsigned integer, advancing 'pos'. Returns false if there
+  // weren't any digits.
+  inline bool parse_number(const char *&pos, const char *end, uint64_t &out) {
+    const char *start = pos;
+    uint64_t value = 0;
+    while (pos != end && *pos >= '0' && *pos <= '9') {
+      value = value * 10 + (*pos - '0');
+      ++pos;
+    }
+    out = value;
+    return pos != start;
+  }
+
+  inline void skip_separator(const char *&pos, const char *end) {
+    while (pos != end && (*pos == ',' || *pos == ' ' || *pos == '\t')) {
+      ++pos;
+    }
+  }
+}
+
+sim::CsvRequestSource::CsvRequestSource()
+  : file_(NULL), chunk_(CSV_CHUNK), begin_(0), end_(0), eof_(false) { }
+
+sim::CsvRequestSource::~CsvRequestSource() {
+  if (file_ != NULL) {
+    fclose(file_);
+  }
+}
+
+bool sim::CsvRequestSource::open(const char *path) {
+  if (file_ != NULL) {
+    fclose(file_);
+  }
+  begin_ = end_ = 0;
+  eof_ = false;
+  file_ = fopen(path, "rb");
+  return file_ != NULL;
+}
+
+bool sim::CsvRequestSource::fill() {
+  if (eof_ || file_ == NULL) {
+    return false;
+  }
+  // Keep any partial line from the previous chunk at the front.
+  size_t remaining = end_ - begin_;
+  if (remaining == chunk_.size()) {
+    // A line longer than the whole chunk. Drop it.
+    remaining = 0;
+    begin_ = end_;
+  }
+  memmove(chunk_.data(), chunk_.data() + begin_, remaining);
+  begin_ = 0;
+  end_ = remaining;
+  size_t got = fread(chunk_.data() + end_, 1, chunk_.size() - end_, file_);
+  end_ += got;
+  if (got == 0) {
+    eof_ = true;
+    if (end_ != 0 && chunk_[end_ - 1] != '\n' && end_ < chunk_.size()) {
+      // Terminate a final line which lacks a newline.
+      chunk_[end_++] = '\n';
+      return true;
+    }
+    return false;
+  }
+  return true;
+}
+
+size_t sim::CsvRequestSource::read(Request *out, size_t max) {
+  size_t count = 0;
+  while (count < max) {
+    const char *start = chunk_.data() + begin_;
+    const char *end = chunk_.data() + end_;
+    const char *newline = (const char*)memchr(start, '\n', end - start);
+    if (newline == NULL) {
+      if (!fill()) {
+        break;
+      }
+      continue;
+    }
+    begin_ = newline + 1 - chunk_.data();
+
+    const char *pos = start;
+    uint64_t tick, source, dest;
+    if (!parse_number(pos, newline, tick)) {
+      // Header, comment or blank line.
+      continue;
+    }
+    skip_separator(pos, newline);
+    if (!parse_number(pos, newline, source)) {
+      continue;
+    }
+    skip_separator(pos, newline);
+    if (!parse_number(pos, newline, dest)) {
+      continue;
+    }
+    out[count++] = Request(tick, source, dest);
+  }
+  return count;
+}
+
+sim::BinaryRequestSource::BinaryRequestSource()
+  : map_(NULL), map_size_(0), records_(NULL), size_(0), next_(0) { }
+
+sim::BinaryRequestSource::~BinaryRequestSource() {
+  close();
+}
+
+bool sim::BinaryRequestSource::open(const char *path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(PackedHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  map_ = map;
+  map_size_ = st.st_size;
+
+  const PackedHeader *header = (const PackedHeader*)map_;
+  if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+      || header->version != VERSION
+      || header->record_size != sizeof(PackedRequest)) {
+    close();
+    return false;
+  }
+  records_ = (const char*)map_ + sizeof(PackedHeader);
+  size_ = (map_size_ - sizeof(PackedHeader)) / sizeof(PackedRequest);
+  next_ = 0;
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void sim::BinaryRequestSource::close() {
+  if (map_ != NULL) {
+    munmap(map_, map_size_);
+  }
+  map_ = NULL;
+  map_size_ = 0;
+  records_ = NULL;
+  size_ = next_ = 0;
+}
+
+size_t sim::BinaryRequestSource::read(Request *out, size_t max) {
+  size_t count = size_ - next_;
+  if (count > max) {
+    count = max;
+  }
+  const PackedRequest *records = (const PackedRequest*)records_ + next_;
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = Request(records[i].tick, records[i].source, records[i].dest);
+  }
+  next_ += count;
+  return count;
+}
+
+sim::BinaryRequestWriter::BinaryRequestWriter()
+  : file_(NULL) { }
+
+sim::BinaryRequestWriter::~BinaryRequestWriter() {
+  close();
+}
+
+bool sim::BinaryRequestWriter::open(const char *path) {
+  close();
+  file_ = fopen(path, "wb");
+  if (file_ == NULL) {
+    return false;
+  }
+  PackedHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.record_size = sizeof(PackedRequest);
+  return fwrite(&header, sizeof(header), 1, file_) == 1;
+}
+
+bool sim::BinaryRequestWriter::write(const Request &request) {
+  PackedRequest record;
+  record.tick = request.tick;
+  record.source = request.source;
+  record.dest = request.dest;
+  return file_ != NULL && fwrite(&record, sizeof(record), 1, file_) == 1;
+}
+
+bool sim::BinaryRequestWriter::close() {
+  if (file_ == NULL) {
+    return true;
+  }
+  bool ok = (fclose(file_) == 0);
+  file_ = NULL;
+  return ok;
+}
+
+std::unique_ptr<sim::RequestSource> sim::open_request_source(
+    const char *path) {
+  std::unique_ptr<BinaryRequestSource> binary(new BinaryRequestSource);
+  if (binary->open(path)) {
+    return std::unique_ptr<RequestSource>(binary.release());
+  }
+  std::unique_ptr<CsvRequestSource> csv(new CsvRequestSource);
+  if (csv->open(path)) {
+    return std::unique_ptr<RequestSource>(csv.release());
+  }
+  return std::unique_ptr<RequestSource>();
+}
+
+sim::RequestFeeder::RequestFeeder(RequestSource &source,
+    size_t batch_size/*=4096*/)
+  : source_(source), batch_(batch_size), begin_(0), end_(0) { }
+
+size_t sim::RequestFeeder::insert_due(Scheduler &scheduler) {
+  size_t next = scheduler.tick_count() + 1;
+  size_t inserted = 0;
+  while (begin_ != end_ || refill()) {
+    const Request &request = batch_[begin_];
+    if (request.tick > next) {
+      break;
+    }
+    if (scheduler.insert_request(request.source, request.dest)) {
+      ++inserted;
+    }
+    ++begin_;
+  }
+  return inserted;
+}
+
+bool sim::RequestFeeder::done() {
+  return begin_ == end_ && !refill();
+}
+
+size_t sim::RequestFeeder::next_tick() {
+  return batch_[begin_].tick;
+}
+
+bool sim::RequestFeeder::refill() {
+  begin_ = 0;
+  end_ = source_.read(batch_.data(), batch_.size());
+  return end_ != 0;
+}
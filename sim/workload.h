@@ -0,0 +1,149 @@
+#ifndef _sim_workload_h_
+#define _sim_workload_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#include "sim/scheduler.h"
+
+namespace sim {
+
+  /**
+   * A stream of Requests in tick order, read a batch at a time so that the
+   * whole workload never needs to be in memory.
+   */
+  class RequestSource {
+   public:
+    virtual ~RequestSource() { }
+
+    /**
+     * Reads up to 'max' requests into 'out', returning the number read. A
+     * return value of 0 means that the source is exhausted.
+     */
+    virtual size_t read(Request *out, size_t max) = 0;
+  };
+
+  /**
+   * Reads 'tick,source,dest' lines from a CSV file in fixed-size chunks.
+   * Lines which don't start with a digit, like a header, are skipped.
+   */
+  class CsvRequestSource : public RequestSource {
+   public:
+    CsvRequestSource();
+    virtual ~CsvRequestSource();
+
+    /**
+     * Opens the provided file, returning false if it couldn't be opened.
+     */
+    bool open(const char *path);
+
+    size_t read(Request *out, size_t max);
+
+   private:
+    bool fill();
+
+    FILE *file_;
+    std::vector<char> chunk_;
+    size_t begin_, end_;
+    bool eof_;
+  };
+
+  /**
+   * Reads packed binary requests (see BinaryRequestWriter) by mapping the
+   * file, so pages are only read in as the stream reaches them.
+   */
+  class BinaryRequestSource : public RequestSource {
+   public:
+    BinaryRequestSource();
+    virtual ~BinaryRequestSource();
+
+    /**
+     * Maps the provided file, returning false if it couldn't be opened or
+     * isn't a packed request file.
+     */
+    bool open(const char *path);
+
+    size_t read(Request *out, size_t max);
+
+   private:
+    void close();
+
+    void *map_;
+    size_t map_size_;
+    const char *records_;
+    size_t size_, next_;
+  };
+
+  /**
+   * Writes requests in the packed binary format read by BinaryRequestSource:
+   * a short header, then 16 bytes per request.
+   */
+  class BinaryRequestWriter {
+   public:
+    BinaryRequestWriter();
+    virtual ~BinaryRequestWriter();
+
+    /**
+     * Creates the provided file, returning false if it couldn't be created.
+     */
+    bool open(const char *path);
+
+    /**
+     * Appends a request. Requests should be written in tick order.
+     */
+    bool write(const Request &request);
+
+    /**
+     * Finishes the file, returning false if anything failed to be written.
+     */
+    bool close();
+
+   private:
+    FILE *file_;
+  };
+
+  /**
+   * Opens a workload file in either format, checking for the binary header
+   * first and falling back to CSV. Returns NULL if it couldn't be opened.
+   */
+  std::unique_ptr<RequestSource> open_request_source(const char *path);
+
+  /**
+   * Feeds requests from a RequestSource into a Scheduler as their ticks come
+   * up, holding only one batch of requests in memory at a time.
+   */
+  class RequestFeeder {
+   public:
+    RequestFeeder(RequestSource &source, size_t batch_size = 4096);
+    virtual ~RequestFeeder() { }
+
+    /**
+     * Inserts every request which is due at or before the scheduler's next
+     * tick. Call this before each tick(). Returns the number of requests
+     * which the scheduler accepted.
+     */
+    size_t insert_due(Scheduler &scheduler);
+
+    /**
+     * Returns whether every request has been inserted.
+     */
+    bool done();
+
+    /**
+     * Returns the tick of the next request to be inserted. Only valid when
+     * done() is false.
+     */
+    size_t next_tick();
+
+   private:
+    bool refill();
+
+    RequestSource &source_;
+    std::vector<Request> batch_;
+    size_t begin_, end_;
+  };
+}
+
+#endif /* _sim_workload_h_ */
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include "sim/arena.h"
+#include "sim/types.h"
+
+TEST(Arena, allocate_reset) {
+  sim::Arena arena(1024);
+  EXPECT_EQ(0, arena.used());
+  char *a = static_cast<char*>(arena.allocate(10, 1));
+  uint64_t *b = arena.allocate_array<uint64_t>(4);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(b) % alignof(uint64_t));
+  EXPECT_GE(reinterpret_cast<char*>(b), a + 10);
+  EXPECT_EQ(16 + 32, arena.used());
+
+  // Rewinding hands out the same memory again.
+  arena.reset();
+  EXPECT_EQ(0, arena.used());
+  EXPECT_EQ(a, arena.allocate(10, 1));
+}
+
+TEST(Arena, overflow_blocks) {
+  sim::Arena arena(64);
+  void *a = arena.allocate(48);
+  void *big = arena.allocate(1000);
+  EXPECT_NE(a, big);
+  // Writing to all of it shouldn't upset anything.
+  memset(big, 0xff, 1000);
+  arena.reset();
+  EXPECT_EQ(a, arena.allocate(48));
+  EXPECT_EQ(big, arena.allocate(1000));
+}
+
+TEST(Arena, floor_sets) {
+  sim::Arena arena;
+  sim::FloorSet a(100, &arena), b(100, &arena);
+  EXPECT_EQ(2 * 2 * sizeof(uint64_t), arena.used());
+  a.insert(5);
+  a.insert(99);
+
+  // Copies have their own storage.
+  sim::FloorSet copy(a);
+  copy.erase(5);
+  EXPECT_TRUE(a.contains(5));
+  EXPECT_EQ(2 * 2 * sizeof(uint64_t), arena.used());
+
+  // Assignment keeps the set's storage in the arena.
+  b = copy;
+  EXPECT_TRUE(b.contains(99));
+  EXPECT_FALSE(b.contains(5));
+  b = sim::FloorSet(100);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(2 * 2 * sizeof(uint64_t), arena.used());
+
+  // Growing past the capacity takes more from the arena.
+  EXPECT_TRUE(a.insert(200));
+  EXPECT_TRUE(a.contains(99));
+  EXPECT_TRUE(a.contains(200));
+  EXPECT_EQ((2 + 2 + 4) * sizeof(uint64_t), arena.used());
+}
+
+TEST(Arena, save_restore) {
+  sim::Arena a(64), b(64);
+  // The second allocation of each doesn't fit in the first block.
+  uint64_t *a1 = a.allocate_array<uint64_t>(4);
+  uint64_t *a2 = a.allocate_array<uint64_t>(6);
+  uint64_t *b1 = b.allocate_array<uint64_t>(4);
+  uint64_t *b2 = b.allocate_array<uint64_t>(6);
+  for (size_t i = 0; i < 4; ++i) {
+    a1[i] = i;
+    b1[i] = 0;
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    a2[i] = 100 + i;
+    b2[i] = 0;
+  }
+  std::vector<char> saved;
+  a.save(saved);
+  EXPECT_EQ(a.used(), saved.size());
+  EXPECT_TRUE(b.restore(saved));
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(i, b1[i]);
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(100 + i, b2[i]);
+  }
+
+  b.allocate(8);
+  EXPECT_FALSE(b.restore(saved));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
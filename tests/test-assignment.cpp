@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "sim/assignment.h"
+#include "sim/random.h"
+
+namespace {
+  const sim::AssignmentSolver::clock::time_point NO_DEADLINE =
+    sim::AssignmentSolver::clock::time_point::max();
+
+  int64_t total(const std::vector<int64_t> &costs, size_t cols,
+      const std::vector<size_t> &assignment) {
+    int64_t sum = 0;
+    for (size_t row = 0; row < assignment.size(); ++row) {
+      sum += costs[row * cols + assignment[row]];
+    }
+    return sum;
+  }
+
+  /**
+   * Tries every assignment of rows to distinct columns.
+   */
+  int64_t brute_force(const std::vector<int64_t> &costs, size_t rows,
+      size_t cols) {
+    std::vector<size_t> perm(cols);
+    for (size_t i = 0; i < cols; ++i) {
+      perm[i] = i;
+    }
+    int64_t best = -1;
+    do {
+      std::vector<size_t> assignment(perm.begin(), perm.begin() + rows);
+      int64_t sum = total(costs, cols, assignment);
+      if (best < 0 || sum < best) {
+        best = sum;
+      }
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    return best;
+  }
+}
+
+TEST(AssignmentSolver, simple) {
+  sim::AssignmentSolver solver;
+  std::vector<int64_t> costs = {
+    4, 1, 3,
+    2, 0, 5,
+    3, 2, 2,
+  };
+  std::vector<size_t> assignment;
+  ASSERT_TRUE(solver.solve(costs.data(), 3, 3, NO_DEADLINE, assignment));
+  ASSERT_EQ(3, assignment.size());
+  EXPECT_EQ(1, assignment[0]);
+  EXPECT_EQ(0, assignment[1]);
+  EXPECT_EQ(2, assignment[2]);
+}
+
+TEST(AssignmentSolver, matches_brute_force) {
+  sim::AssignmentSolver solver;
+  sim::Random random(3);
+  for (size_t trial = 0; trial < 200; ++trial) {
+    size_t cols = 1 + random.below(6);
+    size_t rows = 1 + random.below(cols);
+    std::vector<int64_t> costs(rows * cols);
+    for (int64_t &cost : costs) {
+      cost = random.below(20);
+    }
+    std::vector<size_t> assignment;
+    ASSERT_TRUE(solver.solve(costs.data(), rows, cols, NO_DEADLINE,
+            assignment));
+    std::vector<size_t> used(assignment);
+    std::sort(used.begin(), used.end());
+    EXPECT_TRUE(std::unique(used.begin(), used.end()) == used.end());
+    EXPECT_EQ(brute_force(costs, rows, cols), total(costs, cols, assignment));
+  }
+}
+
+TEST(AssignmentSolver, deadline) {
+  sim::AssignmentSolver solver;
+  std::vector<int64_t> costs(4, 1);
+  std::vector<size_t> assignment;
+  EXPECT_FALSE(solver.solve(costs.data(), 2, 2,
+          sim::AssignmentSolver::clock::now(), assignment));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "sim/batch.h"
+#include "sim/logging.h"
+#include "sim/random.h"
+
+TEST(Random, deterministic) {
+  sim::Random a(5), b(5), c(6);
+  for (size_t i = 0; i < 100; ++i) {
+    uint64_t value = a.next();
+    EXPECT_EQ(value, b.next());
+    EXPECT_NE(value, c.next());
+  }
+}
+
+TEST(Random, below) {
+  sim::Random r(1);
+  std::vector<size_t> counts(7, 0);
+  for (size_t i = 0; i < 7000; ++i) {
+    uint64_t value = r.below(7);
+    ASSERT_LT(value, 7);
+    ++counts[value];
+  }
+  for (size_t count : counts) {
+    EXPECT_GT(count, 800);
+  }
+}
+
+TEST(Batch, single_run) {
+  sim::verbose_enabled = false;
+  sim::Scenario scenario;
+  scenario.floors = 10;
+  scenario.elevators = 2;
+  scenario.requests = 100;
+  scenario.seed = 3;
+  sim::RunResult result = sim::run_scenario(scenario);
+  EXPECT_TRUE(result.completed);
+  // The run lasts at least until the last request has arrived.
+  sim::TrafficGenerator traffic(scenario.floors, scenario.pattern,
+      scenario.rate, scenario.seed, scenario.requests);
+  std::vector<sim::Request> requests(scenario.requests);
+  ASSERT_EQ(scenario.requests,
+      traffic.read(requests.data(), requests.size()));
+  EXPECT_GE(result.ticks, requests.back().tick);
+  EXPECT_GT(result.inserted, 0);
+  EXPECT_EQ(0, result.stats.pending_dests);
+  EXPECT_EQ(0, result.stats.elevator_requests);
+}
+
+TEST(Batch, matches_single_runs) {
+  sim::verbose_enabled = false;
+  std::vector<sim::Scenario> scenarios;
+  for (size_t i = 0; i < 40; ++i) {
+    sim::Scenario scenario;
+    scenario.floors = 5 + i % 20;
+    scenario.elevators = 1 + i % 4;
+    scenario.requests = 200;
+    scenario.seed = i;
+    scenarios.push_back(scenario);
+  }
+
+  sim::BatchRunner runner(4);
+  sim::BatchResult result = runner.run(scenarios);
+  ASSERT_EQ(scenarios.size(), result.runs.size());
+  size_t completed = 0;
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    sim::RunResult single = sim::run_scenario(scenarios[i]);
+    EXPECT_EQ(single.ticks, result.runs[i].ticks);
+    EXPECT_EQ(single.inserted, result.runs[i].inserted);
+    EXPECT_EQ(single.completed, result.runs[i].completed);
+    if (single.completed) {
+      ++completed;
+      EXPECT_LE(result.min_ticks, single.ticks);
+      EXPECT_GE(result.max_ticks, single.ticks);
+    }
+  }
+  EXPECT_EQ(completed, result.completed);
+}
+
+TEST(Batch, reuses_schedulers) {
+  sim::verbose_enabled = false;
+  std::vector<sim::Scenario> scenarios;
+  for (size_t i = 0; i < 200; ++i) {
+    sim::Scenario scenario;
+    scenario.floors = 12;
+    scenario.elevators = 3;
+    scenario.requests = 50;
+    scenario.seed = i;
+    scenario.dispatch = (i % 2) ? sim::LOWEST_ETA : sim::FEWEST_REQUESTS;
+    scenarios.push_back(scenario);
+  }
+
+  // Every thread keeps its Scheduler across runs in the same building.
+  sim::BatchRunner runner(4);
+  sim::BatchResult result = runner.run(scenarios);
+  EXPECT_LE(1, runner.schedulers().created());
+  EXPECT_GE(4, runner.schedulers().created());
+  sim::LatencyStats latency;
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    sim::RunResult single = sim::run_scenario(scenarios[i], &latency);
+    EXPECT_EQ(single.ticks, result.runs[i].ticks);
+    EXPECT_EQ(single.stats.elevator_requests,
+        result.runs[i].stats.elevator_requests);
+  }
+  EXPECT_EQ(latency.wait.count(), result.latency.wait.count());
+  EXPECT_EQ(latency.wait.max(), result.latency.wait.max());
+  EXPECT_EQ(latency.travel.percentile(99),
+      result.latency.travel.percentile(99));
+
+  // And across batches, until the building changes.
+  runner.run(scenarios);
+  EXPECT_GE(4, runner.schedulers().created());
+  for (sim::Scenario &scenario : scenarios) {
+    ++scenario.floors;
+  }
+  runner.run(scenarios);
+  EXPECT_LT(4, runner.schedulers().created());
+  EXPECT_GE(8, runner.schedulers().created());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
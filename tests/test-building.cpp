@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "sim/building.h"
+#include "sim/logging.h"
+#include "sim/random.h"
+
+TEST(Building, split_zones) {
+  std::vector<sim::ZoneConfig> zones = sim::split_zones(100, 3, 4);
+  ASSERT_EQ(3, zones.size());
+  EXPECT_EQ(33, zones[0].top);
+  EXPECT_EQ(66, zones[1].top);
+  EXPECT_EQ(99, zones[2].top);
+  EXPECT_EQ(4, zones[2].elevators);
+
+  // Never more zones than floors to put them in.
+  EXPECT_EQ(2, sim::split_zones(3, 5, 1).size());
+}
+
+TEST(Building, zones) {
+  sim::Building b({sim::ZoneConfig(10, 2), sim::ZoneConfig(20, 2)});
+  EXPECT_EQ(21, b.floors());
+  EXPECT_EQ(2, b.zone_count());
+  EXPECT_EQ(10, b.zone_bottom(1));
+  EXPECT_EQ(0, b.zone_of(0, 5));
+  EXPECT_EQ(0, b.zone_of(9, 15));
+  // The sky lobby is served by the zone in the direction of travel.
+  EXPECT_EQ(1, b.zone_of(10, 15));
+  EXPECT_EQ(0, b.zone_of(10, 5));
+  EXPECT_EQ(1, b.zone_of(20, 5));
+
+  EXPECT_FALSE(b.insert_request(21, 0));
+  EXPECT_FALSE(b.insert_request(4, 4));
+}
+
+TEST(Building, transfers) {
+  sim::verbose_enabled = true;
+  sim::Building b({sim::ZoneConfig(10, 1), sim::ZoneConfig(20, 1),
+        sim::ZoneConfig(30, 1)});
+  // One trip within a zone, and one which crosses all three.
+  EXPECT_TRUE(b.insert_request(12, 18));
+  EXPECT_TRUE(b.insert_request(5, 25));
+  EXPECT_FALSE(b.zone(0).idle());
+  EXPECT_FALSE(b.zone(1).idle());
+  EXPECT_TRUE(b.zone(2).idle());
+  while (!b.idle() && b.tick_count() < 1000) {
+    b.tick();
+  }
+  EXPECT_TRUE(b.idle());
+  EXPECT_EQ(2, b.transfers());
+  EXPECT_EQ(2, b.trip_latency().count());
+  // Each zone carried its own leg of the long trip.
+  EXPECT_EQ(1, b.zone(0).latency().travel.count());
+  EXPECT_EQ(2, b.zone(1).latency().travel.count());
+  EXPECT_EQ(1, b.zone(2).latency().travel.count());
+  // The long trip can't be quicker than riding 20 floors.
+  EXPECT_GT(b.trip_latency().max(), 20);
+}
+
+TEST(Building, merged_trips) {
+  sim::verbose_enabled = false;
+  sim::Building b({sim::ZoneConfig(10, 1), sim::ZoneConfig(20, 1)});
+  // Both ride the same leg to the lobby, then go their separate ways.
+  EXPECT_TRUE(b.insert_request(2, 15));
+  EXPECT_TRUE(b.insert_request(2, 18));
+  while (!b.idle() && b.tick_count() < 1000) {
+    b.tick();
+  }
+  EXPECT_TRUE(b.idle());
+  EXPECT_EQ(2, b.transfers());
+  EXPECT_EQ(2, b.trip_latency().count());
+  EXPECT_EQ(1, b.zone(0).latency().travel.count());
+  EXPECT_EQ(2, b.zone(1).latency().travel.count());
+}
+
+TEST(Building, threaded_matches) {
+  sim::verbose_enabled = false;
+  std::vector<sim::ZoneConfig> zones = sim::split_zones(120, 4, 6);
+  sim::Building s(zones), t(zones, 4);
+  sim::Random random(8);
+  for (size_t i = 0; i < 3000; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      sim::floor_t source = random.below(120), dest = random.below(120);
+      EXPECT_EQ(s.insert_request(source, dest), t.insert_request(source, dest));
+    }
+    s.tick();
+    t.tick();
+  }
+  while (!s.idle() && s.tick_count() < 20000) {
+    s.tick();
+    t.tick();
+  }
+  EXPECT_TRUE(s.idle());
+  EXPECT_TRUE(t.idle());
+  EXPECT_EQ(s.tick_count(), t.tick_count());
+  EXPECT_EQ(s.transfers(), t.transfers());
+  EXPECT_EQ(s.trip_latency().count(), t.trip_latency().count());
+  EXPECT_EQ(s.trip_latency().max(), t.trip_latency().max());
+  EXPECT_EQ(s.trip_latency().percentile(50), t.trip_latency().percentile(50));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -165,6 +165,84 @@ TEST(Elevator, alternating_directions) {
   EXPECT_EQ(sim::Direction::EITHER, e.direction());
 }
 
+TEST(Elevator, eta) {
+  sim::Elevator e(5, 20);
+  // Idle: straight there.
+  EXPECT_EQ(3, e.eta(8, sim::Direction::UP));
+  EXPECT_EQ(5, e.eta(0, sim::Direction::DOWN));
+
+  EXPECT_TRUE(e.insert_request(7, sim::Direction::UP));
+  EXPECT_TRUE(e.insert_request(10, sim::Direction::UP));
+  EXPECT_TRUE(e.insert_request(12, sim::Direction::UP));
+  EXPECT_EQ(1, e.eta(6, sim::Direction::UP));// before any stops
+  EXPECT_EQ(2, e.eta(7, sim::Direction::UP));// already stopping there
+  EXPECT_EQ(4, e.eta(8, sim::Direction::UP));// after stopping at 7
+  EXPECT_EQ(6, e.eta(10, sim::Direction::UP));
+  EXPECT_EQ(12, e.eta(14, sim::Direction::UP));// after all three stops
+
+  // Each result should match the ticks taken by actually running the
+  // elevator there, before the tick where it opens its doors.
+  for (sim::floor_t floor = 5; floor < 20; ++floor) {
+    sim::Elevator copy = e;
+    size_t expected = copy.eta(floor, sim::Direction::UP);
+    copy.insert_request(floor, sim::Direction::UP);
+    size_t ticks = 0;
+    while (copy.tick() != sim::Action::DOOR_OPEN || copy.floor() != floor) {
+      ++ticks;
+    }
+    EXPECT_EQ(expected, ticks) << "floor " << floor;
+  }
+}
+
+TEST(Elevator, eta_after_reversing) {
+  // An idle elevator which accepts a pickup below it still travels down to
+  // it before heading up.
+  sim::Elevator e(10, 30);
+  EXPECT_TRUE(e.insert_request(4, sim::Direction::UP));
+  EXPECT_EQ(6 + 14 + 1, e.eta(18, sim::Direction::UP));
+
+  sim::Elevator d(10, 30);
+  EXPECT_TRUE(d.insert_request(20, sim::Direction::DOWN));
+  EXPECT_EQ(10 + 12 + 1, d.eta(8, sim::Direction::DOWN));
+  EXPECT_TRUE(d.insert_request(4, sim::Direction::DOWN));
+  EXPECT_EQ(10 + 12 + 1, d.eta(8, sim::Direction::DOWN));
+  EXPECT_EQ(10 + 17 + 2, d.eta(3, sim::Direction::DOWN));
+  for (sim::floor_t floor = 0; floor <= 10; ++floor) {
+    sim::Elevator copy = d;
+    size_t expected = copy.eta(floor, sim::Direction::DOWN);
+    copy.insert_request(floor, sim::Direction::DOWN);
+    size_t ticks = 0;
+    while (copy.tick() != sim::Action::DOOR_OPEN || copy.floor() != floor) {
+      ++ticks;
+    }
+    EXPECT_EQ(expected, ticks) << "floor " << floor;
+  }
+}
+
+TEST(Elevator, hash) {
+  sim::Elevator a(0, 20), b(0, 20);
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(a.compute_hash(), a.hash());
+
+  // The same requests in a different order give the same hash.
+  EXPECT_TRUE(a.insert_request(7, sim::Direction::UP));
+  EXPECT_TRUE(a.insert_request(12, sim::Direction::UP));
+  EXPECT_TRUE(b.insert_request(12, sim::Direction::UP));
+  EXPECT_NE(a.hash(), b.hash());
+  EXPECT_TRUE(b.insert_request(7, sim::Direction::UP));
+  EXPECT_TRUE(b.insert_request(7, sim::Direction::UP));
+  EXPECT_EQ(a.hash(), b.hash());
+
+  // Stays up to date as the elevator moves and serves its requests.
+  sim::Elevator start = a;
+  while (a.request_count() != 0) {
+    a.tick();
+    EXPECT_EQ(a.compute_hash(), a.hash()) << "floor " << a.floor();
+    EXPECT_NE(start.hash(), a.hash());
+  }
+  EXPECT_EQ(sim::Elevator(12, 20).hash(), a.hash());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest( &argc, argv );
   return RUN_ALL_TESTS();
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "sim/fleet.h"
+
+namespace {
+  /**
+   * Picks an elevator the same way as the non-vectorized Scheduler.
+   */
+  int select_reference(std::vector<sim::Elevator> &elevators,
+      sim::floor_t floor, sim::Direction direction) {
+    int best_index = -1;
+    for (size_t i = 0; i < elevators.size(); ++i) {
+      if (elevators[i].approve_request(floor, direction)
+          && (best_index < 0 || elevators[i].request_count()
+              < elevators[best_index].request_count())) {
+        best_index = i;
+      }
+    }
+    return best_index;
+  }
+}
+
+TEST(Fleet, empty) {
+  sim::Fleet f;
+  EXPECT_EQ(0, f.size());
+  EXPECT_EQ(-1, f.select(0, sim::Direction::UP));
+}
+
+TEST(Fleet, idle_picks_lowest_index) {
+  sim::Fleet f(3);
+  EXPECT_EQ(0, f.select(2, sim::Direction::UP));
+  EXPECT_EQ(0, f.select(2, sim::Direction::DOWN));
+}
+
+TEST(Fleet, declines_and_fewest_requests) {
+  std::vector<sim::Elevator> elevators(3, sim::Elevator(0, 10));
+  sim::Fleet f(elevators.size());
+
+  // 0: going up from 5 with two requests
+  elevators[0] = sim::Elevator(5, 10);
+  EXPECT_TRUE(elevators[0].insert_request(7, sim::Direction::UP));
+  EXPECT_TRUE(elevators[0].insert_request(8, sim::Direction::UP));
+  // 1: going down from 6 with one request
+  elevators[1] = sim::Elevator(6, 10);
+  EXPECT_TRUE(elevators[1].insert_request(2, sim::Direction::DOWN));
+  // 2: going up from 1 with one request
+  elevators[2] = sim::Elevator(1, 10);
+  EXPECT_TRUE(elevators[2].insert_request(3, sim::Direction::UP));
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    f.update(i, elevators[i]);
+  }
+
+  EXPECT_EQ(2, f.select(6, sim::Direction::UP));// 0 and 2 approve, 2 has fewer
+  EXPECT_EQ(-1, f.select(0, sim::Direction::UP));// all passed or wrong way
+  EXPECT_EQ(1, f.select(3, sim::Direction::DOWN));
+  EXPECT_EQ(1, f.select(6, sim::Direction::DOWN));
+  EXPECT_EQ(-1, f.select(7, sim::Direction::DOWN));
+}
+
+TEST(Fleet, matches_elevators) {
+  // Enough elevators to exercise several SIMD blocks plus a partial one.
+  const sim::floor_t floors = 40;
+  std::vector<sim::Elevator> elevators;
+  srand(1);
+  for (size_t i = 0; i < 37; ++i) {
+    elevators.push_back(sim::Elevator(rand() % floors, floors));
+    if (rand() % 4 != 0) {
+      sim::Direction direction =
+        (rand() % 2 == 0) ? sim::Direction::UP : sim::Direction::DOWN;
+      for (size_t j = rand() % 5; j > 0; --j) {
+        elevators.back().insert_request(rand() % floors, direction);
+      }
+    }
+  }
+  sim::Fleet f(elevators.size());
+  for (size_t i = 0; i < elevators.size(); ++i) {
+    f.update(i, elevators[i]);
+  }
+  for (sim::floor_t floor = 0; floor < floors; ++floor) {
+    EXPECT_EQ(select_reference(elevators, floor, sim::Direction::UP),
+        f.select(floor, sim::Direction::UP));
+    EXPECT_EQ(select_reference(elevators, floor, sim::Direction::DOWN),
+        f.select(floor, sim::Direction::DOWN));
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "sim/histogram.h"
+
+TEST(Histogram, empty) {
+  sim::Histogram h;
+  EXPECT_EQ(0, h.count());
+  EXPECT_EQ(0, h.max());
+  EXPECT_EQ(0, h.mean());
+  EXPECT_EQ(0, h.percentile(50));
+}
+
+TEST(Histogram, small_values_exact) {
+  sim::Histogram h;
+  for (uint64_t i = 1; i <= 100; ++i) {
+    h.record(i);
+  }
+  EXPECT_EQ(100, h.count());
+  EXPECT_EQ(100, h.max());
+  EXPECT_DOUBLE_EQ(50.5, h.mean());
+  EXPECT_EQ(1, h.percentile(0));
+  EXPECT_EQ(50, h.percentile(50));
+  EXPECT_EQ(99, h.percentile(99));
+  EXPECT_EQ(100, h.percentile(99.9));
+  EXPECT_EQ(100, h.percentile(100));
+}
+
+TEST(Histogram, large_values_bounded_error) {
+  sim::Histogram h;
+  uint64_t values[] = {1000, 123456, 98765432, 1ULL << 40, ~0ULL};
+  for (uint64_t value : values) {
+    sim::Histogram single;
+    single.record(value);
+    // The only value is also the max, so it's reported exactly.
+    EXPECT_EQ(value, single.percentile(50));
+
+    single.record(value + 1 < value ? value : value + 1);
+    single.record(0);
+    single.record(~0ULL);
+    uint64_t reported = single.percentile(50);
+    EXPECT_GE(reported, value);
+    EXPECT_LE(reported - value, value / 64 + 1);
+  }
+}
+
+TEST(Histogram, merge_clear) {
+  sim::Histogram a, b;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    a.record(i);
+    b.record(i + 1000);
+  }
+  a.merge(b);
+  EXPECT_EQ(2000, a.count());
+  EXPECT_EQ(1999, a.max());
+  EXPECT_NEAR(1000, a.percentile(50), 1000 / 64 + 1);
+
+  a.clear();
+  EXPECT_EQ(0, a.count());
+  EXPECT_EQ(0, a.percentile(99));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
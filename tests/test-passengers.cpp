@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "sim/logging.h"
+#include "sim/passengers.h"
+#include "sim/scheduler.h"
+
+TEST(PassengerStore, add_remove) {
+  sim::PassengerStore store;
+  EXPECT_EQ(0, store.size());
+  uint32_t a = store.add(5, 1, 7);
+  uint32_t b = store.add(6, 7, 1);
+  EXPECT_EQ(2, store.size());
+  EXPECT_EQ(5, store.tick(a));
+  EXPECT_EQ(1, store.source(a));
+  EXPECT_EQ(7, store.dest(a));
+  EXPECT_EQ(sim::PassengerStore::NONE, store.car(a));
+  EXPECT_EQ(sim::PassengerStore::NONE, store.next(a));
+
+  store.set_next(a, b);
+  store.set_car(b, 3);
+  store.set_tick(b, 9);
+  EXPECT_EQ(b, store.next(a));
+  EXPECT_EQ(3, store.car(b));
+  EXPECT_EQ(9, store.tick(b));
+
+  // Freed slots are reused, and come back reinitialized.
+  store.remove(a);
+  EXPECT_EQ(1, store.size());
+  uint32_t c = store.add(10, 2, 4);
+  EXPECT_EQ(a, c);
+  EXPECT_EQ(10, store.tick(c));
+  EXPECT_EQ(sim::PassengerStore::NONE, store.next(c));
+  EXPECT_EQ(2, store.size());
+  EXPECT_GE(store.bytes(), 2 * 5 * sizeof(uint32_t));
+
+  store.clear();
+  EXPECT_EQ(0, store.size());
+  EXPECT_EQ(0, store.add(1, 0, 1));
+}
+
+TEST(PassengerStore, bounded_by_peak) {
+  // Passengers coming and going only use as many slots as are present at
+  // once.
+  sim::PassengerStore store;
+  uint32_t slots[4];
+  for (size_t round = 0; round < 1000; ++round) {
+    for (size_t i = 0; i < 4; ++i) {
+      slots[i] = store.add(round, i, i + 1);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+      EXPECT_GT(4, slots[i]);
+      store.remove(slots[i]);
+    }
+  }
+  EXPECT_EQ(0, store.size());
+  EXPECT_GE(8, store.capacity());
+}
+
+TEST(PassengerStore, scheduler_passengers) {
+  sim::verbose_enabled = false;
+  sim::Scheduler s(10, 1);
+  EXPECT_TRUE(s.insert_request(0, 5));
+  // Merged without passenger mode.
+  EXPECT_FALSE(s.insert_request(0, 5));
+  s.run_until(100);
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(1, s.latency().travel.count());
+
+  s.reset();
+  s.set_passengers(true, 0);
+  std::vector<sim::Arrival> arrivals;
+  s.set_arrivals(&arrivals);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(s.insert_request(0, 5));
+  }
+  EXPECT_EQ(10, s.stats().waiting);
+  EXPECT_EQ(1, s.stats().pending_dests);
+  EXPECT_EQ(10, s.passengers().size());
+  s.tick();
+  EXPECT_EQ(10, s.load(0));
+  EXPECT_EQ(10, s.stats().riding);
+  EXPECT_EQ(0, s.stats().waiting);
+  s.run_until(100);
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(0, s.load(0));
+  EXPECT_EQ(0, s.passengers().size());
+  EXPECT_EQ(10, s.latency().wait.count());
+  EXPECT_EQ(10, s.latency().travel.count());
+  ASSERT_EQ(10, arrivals.size());
+  for (const sim::Arrival &arrival : arrivals) {
+    EXPECT_EQ(0, arrival.source);
+    EXPECT_EQ(5, arrival.dest);
+    EXPECT_EQ(1, arrival.pickup_tick);
+    EXPECT_EQ(7, arrival.dropoff_tick);
+  }
+}
+
+TEST(PassengerStore, scheduler_capacity) {
+  sim::verbose_enabled = false;
+  sim::Scheduler s(10, 1);
+  s.set_passengers(true, 4);
+  std::vector<sim::Arrival> arrivals;
+  s.set_arrivals(&arrivals);
+  // Ten passengers for two floors: only four fit in each trip.
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(s.insert_request(0, (i % 2) ? 3 : 6));
+  }
+  size_t max_load = 0;
+  for (size_t i = 0; i < 200 && !s.idle(); ++i) {
+    s.tick();
+    max_load = std::max(max_load, s.load(0));
+    EXPECT_EQ(s.load(0), s.stats().riding);
+  }
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(4, max_load);
+  EXPECT_EQ(0, s.passengers().size());
+  EXPECT_EQ(10, s.latency().wait.count());
+  ASSERT_EQ(10, arrivals.size());
+  // They board in the order they arrived, four at a time.
+  size_t first_trip = 0;
+  for (const sim::Arrival &arrival : arrivals) {
+    first_trip += (arrival.pickup_tick == 1);
+  }
+  EXPECT_EQ(4, first_trip);
+  EXPECT_EQ(0, s.stats().pending_groups);
+  EXPECT_EQ(0, s.stats().accepted_groups);
+}
+
+TEST(PassengerStore, scheduler_capacity_many_cars) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 30;
+  const size_t elevators = 4;
+  sim::Scheduler s(floors, elevators);
+  s.set_dispatch(sim::LOWEST_ETA);
+  s.set_passengers(true, 8);
+  srand(3);
+  // A morning rush from the lobby, plus some inter-floor traffic.
+  size_t inserted = 0;
+  for (size_t i = 0; i < 2000; ++i) {
+    sim::floor_t source = (i % 3) ? 0 : rand() % floors;
+    sim::floor_t dest = rand() % floors;
+    inserted += s.insert_request(source, dest);
+    s.tick();
+    for (size_t e = 0; e < elevators; ++e) {
+      EXPECT_GE(8, s.load(e));
+    }
+  }
+  s.run_until(100000);
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(inserted, s.latency().travel.count());
+  EXPECT_EQ(0, s.stats().waiting);
+  EXPECT_EQ(0, s.stats().riding);
+
+  // Snapshots carry the passengers along.
+  sim::Scheduler a(floors, elevators), b(floors, elevators);
+  a.set_passengers(true, 2);
+  b.set_passengers(true, 2);
+  for (size_t i = 0; i < 50; ++i) {
+    a.insert_request(0, 1 + i % (floors - 1));
+    a.tick();
+  }
+  sim::Scheduler::Snapshot snapshot;
+  a.save(snapshot);
+  EXPECT_TRUE(b.restore(snapshot));
+  a.run_until(5000);
+  b.run_until(5000);
+  EXPECT_TRUE(a.idle());
+  EXPECT_TRUE(b.idle());
+  EXPECT_EQ(50, a.latency().travel.count());
+  EXPECT_EQ(a.latency().travel.count(), b.latency().travel.count());
+  EXPECT_EQ(a.latency().wait.max(), b.latency().wait.max());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
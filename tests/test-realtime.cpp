@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "sim/logging.h"
+#include "sim/realtime.h"
+
+TEST(RealtimeDriver, paces_ticks) {
+  sim::verbose_enabled = false;
+  sim::Scheduler s(10, 2);
+  s.insert_request(0, 9);
+  sim::RealtimeDriver driver(s, 2000000);
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  EXPECT_EQ(10, driver.run(10));
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  // The tenth tick starts 9 periods in.
+  EXPECT_GE(elapsed, 0.018);
+  EXPECT_EQ(10, s.tick_count());
+  EXPECT_EQ(10, driver.tick_durations().count());
+  EXPECT_EQ(10, driver.start_lateness().count());
+}
+
+TEST(RealtimeDriver, deadline_misses) {
+  sim::verbose_enabled = false;
+  sim::Scheduler s(10, 2);
+  // No tick can finish in no time at all.
+  sim::RealtimeDriver driver(s, 0);
+  EXPECT_EQ(5, driver.run(5));
+  ASSERT_EQ(5, driver.misses().size());
+  EXPECT_EQ(1, driver.misses()[0].tick);
+  EXPECT_EQ(5, driver.misses()[4].tick);
+  EXPECT_GT(driver.misses()[0].duration_ns, 0);
+}
+
+TEST(RealtimeDriver, stop) {
+  sim::Scheduler s(10, 2);
+  sim::RealtimeDriver driver(s, 1000000);
+  driver.stop();
+  EXPECT_EQ(0, driver.run(10));
+  EXPECT_EQ(0, s.tick_count());
+}
+
+TEST(RealtimeDriver, pin_current_thread) {
+  // Core 0 always exists, so this should work wherever pinning does.
+#ifdef __linux__
+  EXPECT_TRUE(sim::pin_current_thread(0));
+#endif
+  EXPECT_FALSE(sim::pin_current_thread(size_t(1) << 20));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "sim/logging.h"
+#include "sim/request_queue.h"
+#include "sim/scheduler.h"
+
+TEST(RequestQueue, submit_drain) {
+  sim::RequestQueue queue(2, 4);
+  sim::RequestQueue::Producer a = queue.producer(0), b = queue.producer(1);
+  sim::Request out[8];
+  EXPECT_EQ(0, queue.drain(out, 8));
+
+  EXPECT_TRUE(a.submit(1, 2));
+  EXPECT_TRUE(a.submit(3, 4));
+  EXPECT_TRUE(b.submit(5, 6));
+  ASSERT_EQ(3, queue.drain(out, 8));
+  EXPECT_EQ(1, out[0].source);
+  EXPECT_EQ(2, out[0].dest);
+  EXPECT_EQ(3, out[1].source);
+  EXPECT_EQ(5, out[2].source);
+  EXPECT_EQ(0, queue.drain(out, 8));
+}
+
+TEST(RequestQueue, full_lane) {
+  sim::RequestQueue queue(1, 3);
+  sim::RequestQueue::Producer producer = queue.producer(0);
+  // Rounded up to 4.
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(producer.submit(i, i + 1));
+  }
+  EXPECT_FALSE(producer.submit(9, 10));
+  EXPECT_EQ(1, queue.dropped());
+
+  // Partial drains free up room as they go.
+  sim::Request out[4];
+  ASSERT_EQ(2, queue.drain(out, 2));
+  EXPECT_EQ(0, out[0].source);
+  EXPECT_EQ(1, out[1].source);
+  EXPECT_TRUE(producer.submit(4, 5));
+  ASSERT_EQ(3, queue.drain(out, 4));
+  EXPECT_EQ(2, out[0].source);
+  EXPECT_EQ(4, out[2].source);
+}
+
+TEST(RequestQueue, drain_marked) {
+  sim::RequestQueue queue(2, 8);
+  sim::RequestQueue::Producer a = queue.producer(0), b = queue.producer(1);
+  sim::Request out[8];
+  queue.mark();
+  EXPECT_TRUE(a.submit(1, 2));
+  EXPECT_EQ(0, queue.drain_marked(out, 8));
+
+  // Only what was queued by the mark comes out, however much is added.
+  queue.mark();
+  EXPECT_TRUE(b.submit(3, 4));
+  EXPECT_TRUE(a.submit(5, 6));
+  ASSERT_EQ(1, queue.drain_marked(out, 8));
+  EXPECT_EQ(1, out[0].source);
+  EXPECT_EQ(0, queue.drain_marked(out, 8));
+
+  queue.mark();
+  ASSERT_EQ(1, queue.drain_marked(out, 1));
+  ASSERT_EQ(1, queue.drain_marked(out, 8));
+  EXPECT_EQ(0, queue.drain_marked(out, 8));
+
+  // drain() takes everything, including what's already past the mark.
+  EXPECT_TRUE(a.submit(7, 8));
+  queue.mark();
+  EXPECT_TRUE(b.submit(9, 10));
+  EXPECT_EQ(2, queue.drain(out, 8));
+  EXPECT_EQ(0, queue.drain_marked(out, 8));
+}
+
+TEST(RequestQueue, threaded_producers) {
+  const size_t producers = 4, per_producer = 20000;
+  sim::RequestQueue queue(producers, 64);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < producers; ++i) {
+    threads.emplace_back([&queue, i]() {
+      sim::RequestQueue::Producer producer = queue.producer(i);
+      for (size_t n = 0; n < per_producer; ) {
+        // Retry when full, so that every request gets through.
+        if (producer.submit(i, n)) {
+          ++n;
+        }
+      }
+    });
+  }
+
+  // Each lane's requests must come out complete and in order.
+  std::vector<size_t> next(producers, 0);
+  size_t total = 0;
+  sim::Request out[32];
+  while (total < producers * per_producer) {
+    size_t count = queue.drain(out, 32);
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_LT(out[i].source, producers);
+      ASSERT_EQ(next[out[i].source], out[i].dest);
+      ++next[out[i].source];
+    }
+    total += count;
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, queue.drain(out, 32));
+}
+
+TEST(RequestQueue, scheduler_drains_on_tick) {
+  sim::verbose_enabled = false;
+  sim::RequestQueue queue(1, 1024);
+  sim::Scheduler s(10, 2), direct(10, 2);
+  s.set_request_queue(&queue);
+  sim::RequestQueue::Producer producer = queue.producer(0);
+  for (size_t i = 0; i < 600; ++i) {
+    sim::floor_t source = i % 10, dest = (i * 7 + 3) % 10;
+    producer.submit(source, dest);
+    direct.insert_request(source, dest);
+  }
+  // Nothing's been inserted until the tick starts.
+  EXPECT_TRUE(s.idle());
+  s.tick();
+  direct.tick();
+  EXPECT_FALSE(s.idle());
+  EXPECT_EQ(direct.stats().pending_dests, s.stats().pending_dests);
+  EXPECT_EQ(direct.stats().elevator_requests, s.stats().elevator_requests);
+  s.run_until(1000);
+  direct.run_until(1000);
+  EXPECT_EQ(direct.idle(), s.idle());
+  EXPECT_EQ(direct.latency().wait.count(), s.latency().wait.count());
+}
+
+TEST(RequestQueue, scheduler_does_not_skip) {
+  sim::verbose_enabled = false;
+  sim::RequestQueue queue(1, 16);
+  sim::Scheduler s(30, 1);
+  EXPECT_TRUE(s.insert_request(20, 25));
+  s.tick();
+  // Without a queue, the travel to floor 20 is skipped over in one step.
+  std::unique_ptr<sim::Scheduler> fork = s.fork();
+  EXPECT_EQ(20, fork->advance_to_next_event());
+  // With one, requests could be submitted at any tick.
+  s.set_request_queue(&queue);
+  EXPECT_EQ(1, s.advance_to_next_event());
+  queue.producer(0).submit(2, 3);
+  s.run_until(5);
+  EXPECT_EQ(1, s.stats().pending_groups + s.stats().accepted_groups);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
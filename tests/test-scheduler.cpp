@@ -3,6 +3,20 @@
 #include "sim/logging.h"
 
 namespace {
+  /**
+   * A dispatch policy which ignores everything but distance.
+   */
+  class NearestPolicy {
+   public:
+    typedef sim::floor_t score_t;
+
+    template <typename Car>
+    static score_t score(const Car &car, sim::floor_t floor,
+        sim::Direction direction) {
+      return (car.floor() < floor) ? floor - car.floor() : car.floor() - floor;
+    }
+  };
+
   /**
    * A scheduler which provides access to its internal state.
    */
@@ -141,6 +155,631 @@ TEST(Scheduler, dual_elevator_request_chain) {
   s.tick();// 11: e0 and e1 are idle
 }
 
+TEST(Scheduler, stats) {
+  TestScheduler s(5, 1);
+  sim::Elevator &e = s.peek_elevators()[0];
+  EXPECT_EQ(0, s.stats().pending_groups);
+  EXPECT_EQ(0, s.stats().pending_dests);
+
+  EXPECT_TRUE(s.insert_request(2, 4));
+  EXPECT_TRUE(s.insert_request(2, 3));
+  EXPECT_FALSE(s.insert_request(2, 3));
+  EXPECT_TRUE(s.insert_request(3, 0));
+  EXPECT_EQ(2, s.stats().pending_groups);
+  EXPECT_EQ(0, s.stats().accepted_groups);
+  EXPECT_EQ(3, s.stats().pending_dests);
+  EXPECT_EQ(0, s.stats().elevator_requests);
+
+  s.tick();// Elevator takes the up pickup at 2 and moves to floor 1
+  EXPECT_EQ(1, s.stats().pending_groups);
+  EXPECT_EQ(1, s.stats().accepted_groups);
+  EXPECT_EQ(3, s.stats().pending_dests);
+  EXPECT_EQ(1, s.stats().elevator_requests);
+
+  s.tick();// floor 2
+  s.tick();// consume 2, dropoffs at 3 and 4 are handed over
+  EXPECT_EQ(1, s.stats().pending_groups);
+  EXPECT_EQ(0, s.stats().accepted_groups);
+  EXPECT_EQ(1, s.stats().pending_dests);
+  EXPECT_EQ(2, s.stats().elevator_requests);
+  EXPECT_EQ(e.request_count(), s.stats().elevator_requests);
+
+  while (!s.idle()) {
+    s.tick();
+  }
+  EXPECT_EQ(0, s.stats().pending_groups);
+  EXPECT_EQ(0, s.stats().accepted_groups);
+  EXPECT_EQ(0, s.stats().pending_dests);
+  EXPECT_EQ(0, s.stats().elevator_requests);
+  EXPECT_EQ(0, e.request_count());
+}
+
+TEST(Scheduler, vectorized_matches) {
+  sim::verbose_enabled = false;
+  TestScheduler s(30, 13), v(30, 13);
+  v.set_vectorized(true);
+  srand(2);
+  for (size_t tick = 0; tick < 3000; ++tick) {
+    if (tick < 2000) {
+      sim::floor_t source = rand() % 30, dest = rand() % 30;
+      EXPECT_EQ(s.insert_request(source, dest), v.insert_request(source, dest));
+    }
+    s.tick();
+    v.tick();
+    for (size_t i = 0; i < 13; ++i) {
+      sim::Elevator &se = s.peek_elevators()[i], &ve = v.peek_elevators()[i];
+      ASSERT_EQ(se.floor(), ve.floor());
+      ASSERT_EQ(se.direction(), ve.direction());
+      ASSERT_EQ(se.request_count(), ve.request_count());
+    }
+  }
+}
+
+TEST(Scheduler, threaded_matches) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 60;
+  const size_t elevators = 300;
+  TestScheduler s(floors, elevators), t(floors, elevators);
+  t.set_threads(4);
+  srand(3);
+  for (size_t tick = 0; tick < 2000; ++tick) {
+    for (size_t i = 0; tick < 1500 && i < 20; ++i) {
+      sim::floor_t source = rand() % floors, dest = rand() % floors;
+      EXPECT_EQ(s.insert_request(source, dest), t.insert_request(source, dest));
+    }
+    s.tick();
+    t.tick();
+    for (size_t i = 0; i < elevators; ++i) {
+      sim::Elevator &se = s.peek_elevators()[i], &te = t.peek_elevators()[i];
+      ASSERT_EQ(se.floor(), te.floor());
+      ASSERT_EQ(se.direction(), te.direction());
+      ASSERT_EQ(se.request_count(), te.request_count());
+    }
+    ASSERT_EQ(s.idle(), t.idle());
+  }
+}
+
+TEST(Scheduler, scheduled_requests) {
+  sim::verbose_enabled = true;
+  TestScheduler s(5, 1);
+  EXPECT_FALSE(s.schedule_request(3, 2, 2));
+  EXPECT_FALSE(s.schedule_request(3, 2, 5));
+  EXPECT_TRUE(s.schedule_request(3, 2, 4));
+  EXPECT_FALSE(s.idle());
+
+  s.tick();// 1
+  s.tick();// 2
+  EXPECT_EQ(0, s.stats().pending_dests);
+  s.tick();// 3: request arrives and the elevator takes it
+  EXPECT_EQ(1, s.stats().pending_dests);
+  EXPECT_EQ(3, s.tick_count());
+  EXPECT_EQ(1, s.peek_elevators()[0].floor());
+}
+
+TEST(Scheduler, advance_to_next_event) {
+  sim::verbose_enabled = true;
+  TestScheduler s(20, 1);
+  sim::Elevator &e = s.peek_elevators()[0];
+  EXPECT_EQ(0, s.advance_to_next_event());
+
+  EXPECT_TRUE(s.insert_request(10, 15));
+  EXPECT_EQ(1, s.advance_to_next_event());// elevator takes the pickup
+  EXPECT_EQ(1, e.floor());
+  EXPECT_EQ(10, s.advance_to_next_event());// skip to 10 and open doors
+  EXPECT_EQ(11, s.tick_count());
+  EXPECT_EQ(10, e.floor());
+  EXPECT_EQ(1, e.request_count());
+  EXPECT_EQ(6, s.advance_to_next_event());// skip to 15 and open doors
+  EXPECT_EQ(15, e.floor());
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(0, s.advance_to_next_event());
+
+  EXPECT_TRUE(s.schedule_request(100, 3, 1));
+  EXPECT_EQ(83, s.advance_to_next_event());// skip to tick 100
+  EXPECT_EQ(100, s.tick_count());
+  EXPECT_EQ(14, e.floor());
+  s.run_until(1000);
+  EXPECT_EQ(1000, s.tick_count());
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(1, e.floor());
+}
+
+TEST(Scheduler, run_until_matches) {
+  sim::verbose_enabled = false;
+  // Small buildings, so that elevators often pass pickups which are waiting.
+  for (unsigned seed = 0; seed < 300; ++seed) {
+    const sim::floor_t floors = 10 + seed % 31;
+    const size_t elevators = 1 + seed % 3;
+    TestScheduler s(floors, elevators), r(floors, elevators);
+    srand(seed);
+    size_t tick = 0;
+    for (size_t i = 0; i < 60; ++i) {
+      // Sparse requests, so that there's travel to skip over.
+      tick += 1 + rand() % 15;
+      sim::floor_t source = rand() % floors, dest = rand() % floors;
+      EXPECT_EQ(s.schedule_request(tick, source, dest),
+          r.schedule_request(tick, source, dest));
+    }
+    for (size_t checkpoint = 1 + seed % 7; checkpoint < tick + 200;
+         checkpoint += 7) {
+      while (s.tick_count() < checkpoint) {
+        s.tick();
+      }
+      r.run_until(checkpoint);
+      ASSERT_EQ(s.tick_count(), r.tick_count());
+      ASSERT_EQ(s.idle(), r.idle());
+      ASSERT_EQ(s.state_hash(), r.state_hash())
+        << "seed " << seed << ", tick " << checkpoint;
+    }
+    EXPECT_EQ(s.latency().wait.count(), r.latency().wait.count());
+    EXPECT_EQ(s.latency().wait.mean(), r.latency().wait.mean());
+    EXPECT_EQ(s.latency().travel.max(), r.latency().travel.max());
+  }
+}
+
+TEST(Scheduler, run_until_against_accept_direction) {
+  sim::verbose_enabled = false;
+  TestScheduler s(20, 1), r(20, 1);
+  for (TestScheduler *scheduler : {&s, &r}) {
+    EXPECT_TRUE(scheduler->insert_request(10, 11));
+    scheduler->run_until(15);
+    ASSERT_TRUE(scheduler->idle());
+    // The elevator at floor 11 heads down to pick up going up at floor 5...
+    EXPECT_TRUE(scheduler->insert_request(5, 6));
+    scheduler->tick();
+    // ...and approves this pickup once it reaches floor 7 on its way.
+    EXPECT_TRUE(scheduler->insert_request(7, 8));
+  }
+  // From tick 16, the elevator travels from floor 10 to floor 5.
+  for (size_t checkpoint : {21, 30, 40}) {
+    while (s.tick_count() < checkpoint) {
+      s.tick();
+    }
+    r.run_until(checkpoint);
+    ASSERT_EQ(s.state_hash(), r.state_hash()) << "tick " << checkpoint;
+  }
+  EXPECT_TRUE(r.idle());
+  EXPECT_EQ(s.latency().wait.mean(), r.latency().wait.mean());
+}
+
+TEST(Scheduler, latency) {
+  sim::verbose_enabled = true;
+  TestScheduler s(20, 1);
+  EXPECT_TRUE(s.insert_request(10, 15));
+  EXPECT_TRUE(s.insert_request(10, 12));
+  s.tick();// elevator takes the pickup
+  EXPECT_EQ(0, s.latency().wait.count());
+  s.run_until(11);// doors open at 10
+  EXPECT_EQ(2, s.latency().wait.count());
+  EXPECT_EQ(10, s.latency().wait.max());
+  EXPECT_EQ(0, s.latency().travel.count());
+
+  // Inserted while the first riders are on board.
+  EXPECT_TRUE(s.insert_request(13, 14));
+  s.run_until(100);
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(3, s.latency().wait.count());
+  EXPECT_EQ(4, s.latency().wait.percentile(0));// picked up at 13 on tick 16
+  EXPECT_EQ(3, s.latency().travel.count());
+  EXPECT_EQ(2, s.latency().travel.percentile(0));// 13 -> 14
+  EXPECT_EQ(3, s.latency().travel.percentile(50));// 10 -> 12
+  EXPECT_EQ(9, s.latency().travel.max());// 10 -> 15, stopping at 12, 13, 14
+}
+
+TEST(Scheduler, lowest_eta_dispatch) {
+  sim::verbose_enabled = true;
+  TestScheduler s(50, 2);
+  s.set_dispatch(sim::LOWEST_ETA);
+  // Send elevator 0 up to 40, while elevator 1 sits idle at 0.
+  EXPECT_TRUE(s.insert_request(0, 40));
+  s.tick();
+  s.tick();
+  EXPECT_EQ(1, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(0, s.peek_elevators()[1].request_count());
+  s.run_until(30);
+
+  // A pickup just above elevator 0 goes to it, even though it's busier.
+  sim::floor_t floor = s.peek_elevators()[0].floor();
+  EXPECT_TRUE(s.insert_request(floor + 2, floor + 4));
+  s.tick();
+  EXPECT_EQ(2, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(0, s.peek_elevators()[1].request_count());
+
+  sim::Dispatch dispatch;
+  EXPECT_TRUE(sim::parse_dispatch("eta", dispatch));
+  EXPECT_EQ(sim::LOWEST_ETA, dispatch);
+  EXPECT_FALSE(sim::parse_dispatch("nearest", dispatch));
+}
+
+TEST(Scheduler, batch_dispatch) {
+  sim::verbose_enabled = true;
+  TestScheduler s(20, 2);
+  s.peek_elevators()[1] = sim::Elevator(5, 20);
+  s.set_dispatch(sim::BATCH);
+  EXPECT_TRUE(s.insert_request(4, 10));
+  EXPECT_TRUE(s.insert_request(6, 10));
+  s.tick();
+  // Greedily, elevator 1 would take floor 4 and then floor 6 on its way
+  // back up. Together, it's better for elevator 0 to come up to floor 4.
+  EXPECT_EQ(1, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(1, s.peek_elevators()[1].request_count());
+  EXPECT_EQ(1, s.peek_elevators()[0].floor());
+  EXPECT_EQ(6, s.peek_elevators()[1].floor());
+}
+
+TEST(Scheduler, batch_without_budget_matches_eta) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 40;
+  const size_t elevators = 5;
+  TestScheduler s(floors, elevators), r(floors, elevators);
+  s.set_dispatch(sim::LOWEST_ETA);
+  r.set_dispatch(sim::BATCH);
+  r.set_batch_budget(0);
+  srand(5);
+  for (size_t i = 0; i < 2000; ++i) {
+    sim::floor_t source = rand() % floors, dest = rand() % floors;
+    EXPECT_EQ(s.insert_request(source, dest), r.insert_request(source, dest));
+    s.tick();
+    r.tick();
+    for (size_t i = 0; i < elevators; ++i) {
+      sim::Elevator &se = s.peek_elevators()[i], &re = r.peek_elevators()[i];
+      ASSERT_EQ(se.floor(), re.floor());
+      ASSERT_EQ(se.request_count(), re.request_count());
+    }
+  }
+}
+
+TEST(Scheduler, rollout_dispatch) {
+  sim::verbose_enabled = true;
+  TestScheduler s(20, 2), e(20, 2);
+  s.set_dispatch(sim::ROLLOUT);
+  s.set_rollout(32, 1000000);
+  e.set_dispatch(sim::LOWEST_ETA);
+  for (TestScheduler *scheduler : {&s, &e}) {
+    scheduler->peek_elevators()[1] = sim::Elevator(10, 20);
+    EXPECT_TRUE(scheduler->insert_request(5, 6));
+    for (sim::floor_t dest = 15; dest < 20; ++dest) {
+      EXPECT_TRUE(scheduler->schedule_request(3, 0, dest));
+    }
+    scheduler->tick();
+  }
+  // Both elevators are 5 floors away, so by ETA the tie goes to elevator 0.
+  // Looking ahead shows that elevator 0 should stay put for the requests
+  // which are about to arrive at floor 0.
+  EXPECT_EQ(1, e.peek_elevators()[0].request_count());
+  EXPECT_EQ(0, e.peek_elevators()[1].request_count());
+  EXPECT_EQ(0, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(1, s.peek_elevators()[1].request_count());
+}
+
+TEST(Scheduler, rollout_passengers) {
+  sim::verbose_enabled = false;
+  TestScheduler s(20, 2);
+  s.set_dispatch(sim::ROLLOUT);
+  s.set_rollout(32, 1000000);
+  s.set_passengers(true, 1);
+  // Elevator 0 picks up a passenger at floor 2, and is then full.
+  EXPECT_TRUE(s.insert_request(2, 8));
+  while (s.load(0) == 0) {
+    s.tick();
+  }
+  s.tick();
+  ASSERT_EQ(3, s.peek_elevators()[0].floor());
+  ASSERT_EQ(0, s.peek_elevators()[1].floor());
+
+  // Elevator 0 is closer and already heading up past floor 5, but has no
+  // room. Looking ahead with capacity shows elevator 1 should go instead.
+  EXPECT_TRUE(s.insert_request(5, 9));
+  s.tick();
+  EXPECT_EQ(1, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(1, s.peek_elevators()[1].request_count());
+  s.run_until(100);
+  EXPECT_TRUE(s.idle());
+  EXPECT_EQ(2, s.latency().travel.count());
+}
+
+TEST(Scheduler, rollout_without_budget_matches_eta) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 40;
+  const size_t elevators = 5;
+  TestScheduler s(floors, elevators), r(floors, elevators);
+  s.set_dispatch(sim::LOWEST_ETA);
+  r.set_dispatch(sim::ROLLOUT);
+  r.set_rollout(32, 0);
+  srand(5);
+  for (size_t i = 0; i < 2000; ++i) {
+    sim::floor_t source = rand() % floors, dest = rand() % floors;
+    EXPECT_EQ(s.insert_request(source, dest), r.insert_request(source, dest));
+    s.tick();
+    r.tick();
+    for (size_t i = 0; i < elevators; ++i) {
+      sim::Elevator &se = s.peek_elevators()[i], &re = r.peek_elevators()[i];
+      ASSERT_EQ(se.floor(), re.floor());
+      ASSERT_EQ(se.request_count(), re.request_count());
+    }
+  }
+}
+
+TEST(Scheduler, rollout_threaded_matches) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 30;
+  const size_t elevators = 6;
+  TestScheduler s(floors, elevators), t(floors, elevators);
+  s.set_dispatch(sim::ROLLOUT);
+  t.set_dispatch(sim::ROLLOUT);
+  // Don't let a slow machine fall back to ETA partway through.
+  s.set_rollout(16, 10000000);
+  t.set_rollout(16, 10000000);
+  t.set_threads(4);
+  srand(9);
+  for (size_t i = 0; i < 300; ++i) {
+    sim::floor_t source = rand() % floors, dest = rand() % floors;
+    EXPECT_EQ(s.insert_request(source, dest), t.insert_request(source, dest));
+    s.tick();
+    t.tick();
+    for (size_t i = 0; i < elevators; ++i) {
+      sim::Elevator &se = s.peek_elevators()[i], &te = t.peek_elevators()[i];
+      ASSERT_EQ(se.floor(), te.floor());
+      ASSERT_EQ(se.request_count(), te.request_count());
+    }
+  }
+  s.run_until(3000);
+  t.run_until(3000);
+  EXPECT_TRUE(s.idle());
+  EXPECT_TRUE(t.idle());
+  EXPECT_EQ(s.latency().wait.count(), t.latency().wait.count());
+  EXPECT_EQ(s.latency().wait.max(), t.latency().wait.max());
+}
+
+TEST(Scheduler, custom_dispatch_policy) {
+  sim::verbose_enabled = true;
+  TestScheduler s(20, 3);
+  s.peek_elevators()[2] = sim::Elevator(10, 20);
+  s.set_dispatch_policy<NearestPolicy>();
+  EXPECT_TRUE(s.insert_request(8, 2));
+  s.tick();
+  EXPECT_EQ(0, s.peek_elevators()[0].request_count());
+  EXPECT_EQ(1, s.peek_elevators()[2].request_count());
+
+  // Same thing, without a scheduler.
+  std::vector<sim::Elevator> cars(3, sim::Elevator(0, 20));
+  cars[1] = sim::Elevator(15, 20);
+  EXPECT_EQ(1, (sim::select_car<NearestPolicy, sim::Elevator>(
+              cars, 12, sim::Direction::UP)));
+  EXPECT_EQ(0, (sim::select_car<sim::FewestRequestsPolicy, sim::Elevator>(
+              cars, 12, sim::Direction::UP)));
+}
+
+TEST(Scheduler, reset) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 30;
+  const size_t elevators = 4;
+  TestScheduler s(floors, elevators);
+  s.set_dispatch(sim::LOWEST_ETA);
+  for (int run = 0; run < 3; ++run) {
+    if (run > 0) {
+      s.reset();
+      EXPECT_EQ(0, s.tick_count());
+      EXPECT_TRUE(s.idle());
+      EXPECT_EQ(0, s.latency().wait.count());
+      for (size_t i = 0; i < elevators; ++i) {
+        EXPECT_EQ(0, s.peek_elevators()[i].floor());
+        EXPECT_EQ(0, s.peek_elevators()[i].request_count());
+      }
+    }
+    // Every run should match a brand new scheduler.
+    TestScheduler fresh(floors, elevators);
+    fresh.set_dispatch(sim::LOWEST_ETA);
+    srand(7);
+    for (size_t i = 0; i < 500; ++i) {
+      sim::floor_t source = rand() % floors, dest = rand() % floors;
+      EXPECT_EQ(fresh.insert_request(source, dest),
+          s.insert_request(source, dest));
+      if (i % 10 == 0 && source != dest) {
+        EXPECT_TRUE(s.schedule_request(i + 5, dest, source));
+        EXPECT_TRUE(fresh.schedule_request(i + 5, dest, source));
+      }
+      fresh.tick();
+      s.tick();
+    }
+    s.run_until(2000);
+    fresh.run_until(2000);
+    EXPECT_EQ(fresh.stats().pending_dests, s.stats().pending_dests);
+    EXPECT_EQ(fresh.latency().wait.count(), s.latency().wait.count());
+    EXPECT_EQ(fresh.latency().wait.max(), s.latency().wait.max());
+    EXPECT_EQ(fresh.latency().travel.percentile(50),
+        s.latency().travel.percentile(50));
+  }
+}
+
+TEST(Scheduler, snapshot_restore) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 40;
+  const size_t elevators = 5;
+  TestScheduler s(floors, elevators);
+  srand(11);
+  for (size_t i = 0; i < 300; ++i) {
+    sim::floor_t source = rand() % floors, dest = rand() % floors;
+    s.insert_request(source, dest);
+    if (source != dest) {
+      EXPECT_TRUE(s.schedule_request(i + 20, dest, source));
+    }
+    s.tick();
+  }
+  TestScheduler::Snapshot snapshot;
+  s.save(snapshot);
+  EXPECT_EQ(300, snapshot.tick_count());
+  std::vector<sim::Elevator> saved = s.peek_elevators();
+
+  // Runs the rest of the simulation the same way each time.
+  auto finish = [](sim::Scheduler &scheduler) {
+    srand(12);
+    for (size_t i = 0; i < 200; ++i) {
+      scheduler.insert_request(rand() % floors, rand() % floors);
+      scheduler.tick();
+    }
+    scheduler.run_until(5000);
+  };
+  auto expect_same = [](const sim::Scheduler &a, const sim::Scheduler &b) {
+    EXPECT_EQ(a.tick_count(), b.tick_count());
+    EXPECT_EQ(a.idle(), b.idle());
+    EXPECT_EQ(a.stats().pending_dests, b.stats().pending_dests);
+    EXPECT_EQ(a.stats().elevator_requests, b.stats().elevator_requests);
+    EXPECT_EQ(a.latency().wait.count(), b.latency().wait.count());
+    EXPECT_EQ(a.latency().wait.max(), b.latency().wait.max());
+    EXPECT_EQ(a.latency().travel.count(), b.latency().travel.count());
+    EXPECT_EQ(a.latency().travel.percentile(90),
+        b.latency().travel.percentile(90));
+  };
+
+  // Restoring into another scheduler picks up where this one left off.
+  TestScheduler other(floors, elevators);
+  EXPECT_TRUE(other.restore(snapshot));
+  EXPECT_EQ(300, other.tick_count());
+  for (size_t i = 0; i < elevators; ++i) {
+    EXPECT_EQ(saved[i].floor(), other.peek_elevators()[i].floor());
+    EXPECT_EQ(saved[i].direction(), other.peek_elevators()[i].direction());
+    EXPECT_EQ(saved[i].request_count(),
+        other.peek_elevators()[i].request_count());
+  }
+  std::unique_ptr<sim::Scheduler> fork = other.fork();
+  finish(s);
+  finish(other);
+  finish(*fork);
+  expect_same(s, other);
+  expect_same(s, *fork);
+
+  // Rewinding the original runs the same future again.
+  EXPECT_TRUE(s.restore(snapshot));
+  EXPECT_EQ(300, s.tick_count());
+  finish(s);
+  expect_same(s, other);
+
+  sim::Scheduler wrong_floors(floors + 1, elevators);
+  sim::Scheduler wrong_elevators(floors, elevators + 1);
+  EXPECT_FALSE(wrong_floors.restore(snapshot));
+  EXPECT_FALSE(wrong_elevators.restore(snapshot));
+  EXPECT_FALSE(s.restore(TestScheduler::Snapshot()));
+}
+
+TEST(Scheduler, state_hash) {
+  sim::verbose_enabled = false;
+  const sim::floor_t floors = 40;
+  const size_t elevators = 12;
+  TestScheduler s(floors, elevators), t(floors, elevators),
+    v(floors, elevators);
+  s.set_hash_check(true);
+  t.set_threads(3);
+  v.set_vectorized(true);
+  EXPECT_EQ(s.compute_state_hash(), s.state_hash());
+  EXPECT_EQ(s.state_hash(), t.state_hash());
+
+  // The serial, threaded and vectorized schedulers stay in the same state.
+  srand(13);
+  for (size_t tick = 0; tick < 1500; ++tick) {
+    for (size_t i = 0; tick < 1000 && i < 3; ++i) {
+      sim::floor_t source = rand() % floors, dest = rand() % floors;
+      s.insert_request(source, dest);
+      t.insert_request(source, dest);
+      v.insert_request(source, dest);
+    }
+    s.tick();
+    t.tick();
+    v.tick();
+    ASSERT_EQ(s.state_hash(), t.state_hash()) << "tick " << tick;
+    ASSERT_EQ(s.state_hash(), v.state_hash()) << "tick " << tick;
+  }
+  EXPECT_EQ(0, s.hash_mismatch_tick());
+  EXPECT_EQ(s.compute_state_hash(), s.state_hash());
+
+  // Restoring a snapshot restores the hash.
+  TestScheduler::Snapshot snapshot;
+  s.save(snapshot);
+  uint64_t saved = s.state_hash();
+  s.insert_request(5, 30);
+  s.tick();
+  EXPECT_NE(saved, s.state_hash());
+  EXPECT_TRUE(s.restore(snapshot));
+  EXPECT_EQ(saved, s.state_hash());
+  TestScheduler other(floors, elevators);
+  EXPECT_TRUE(other.restore(snapshot));
+  EXPECT_EQ(saved, other.state_hash());
+
+  // A different dispatch soon leaves a different state.
+  TestScheduler fewest(floors, elevators), eta(floors, elevators);
+  eta.set_dispatch(sim::LOWEST_ETA);
+  srand(14);
+  size_t diverged = 0;
+  for (size_t tick = 1; tick < 1000 && diverged == 0; ++tick) {
+    sim::floor_t source = rand() % floors, dest = rand() % floors;
+    fewest.insert_request(source, dest);
+    eta.insert_request(source, dest);
+    fewest.tick();
+    eta.tick();
+    if (fewest.state_hash() != eta.state_hash()) {
+      diverged = tick;
+    }
+  }
+  EXPECT_NE(0, diverged);
+
+  // Passengers, capacity and skipped travel keep the hash in step.
+  TestScheduler p(floors, 3);
+  p.set_passengers(true, 4);
+  p.set_dispatch(sim::LOWEST_ETA);
+  p.set_hash_check(true);
+  size_t when = 0;
+  for (size_t i = 0; i < 600; ++i) {
+    when += rand() % 4;
+    p.schedule_request(when + 1, rand() % floors, rand() % floors);
+  }
+  p.run_until(when + 3000);
+  EXPECT_TRUE(p.idle());
+  EXPECT_EQ(0, p.hash_mismatch_tick());
+  EXPECT_EQ(p.compute_state_hash(), p.state_hash());
+
+  // reset() goes back to where a new scheduler starts.
+  p.reset();
+  EXPECT_EQ(TestScheduler(floors, 3).state_hash(), p.state_hash());
+}
+
+TEST(Scheduler, phase_timings) {
+  sim::verbose_enabled = false;
+  sim::PhaseTimings merged;
+  merged.add(sim::PHASE_PICKUPS, 5);
+  sim::PhaseTimings other;
+  other.add(sim::PHASE_PICKUPS, 3);
+  other.add(sim::PHASE_DROPOFFS, 2);
+  merged.merge(other);
+  EXPECT_EQ(8, merged.time(sim::PHASE_PICKUPS));
+  EXPECT_EQ(2, merged.count(sim::PHASE_PICKUPS));
+  EXPECT_EQ(2, merged.time(sim::PHASE_DROPOFFS));
+  EXPECT_EQ(0, merged.count(sim::PHASE_ELEVATORS));
+  merged.clear();
+  EXPECT_EQ(0, merged.count(sim::PHASE_PICKUPS));
+  EXPECT_STREQ("approvals", sim::string(sim::PHASE_APPROVALS));
+
+  // Each tick times each phase once, however many elevators there are.
+  const size_t elevators = 3;
+  TestScheduler s(20, elevators);
+  for (size_t i = 0; i < 10; ++i) {
+    s.insert_request(i, 19 - i);
+    s.tick();
+  }
+  const sim::PhaseTimings &phases = s.phase_timings();
+  if (sim::PhaseTimings::enabled()) {
+    EXPECT_EQ(10, phases.count(sim::PHASE_PICKUPS));
+    EXPECT_EQ(10, phases.count(sim::PHASE_ELEVATORS));
+    EXPECT_EQ(10, phases.count(sim::PHASE_DROPOFFS));
+    EXPECT_LT(0, phases.count(sim::PHASE_APPROVALS));
+  } else {
+    for (int i = 0; i < sim::PHASE_COUNT; ++i) {
+      EXPECT_EQ(0, phases.count(sim::Phase(i)));
+    }
+  }
+  s.reset();
+  EXPECT_EQ(0, s.phase_timings().count(sim::PHASE_PICKUPS));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest( &argc, argv );
   return RUN_ALL_TESTS();
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "sim/logging.h"
+#include "sim/sweep.h"
+
+namespace {
+  sim::SweepGrid small_grid() {
+    sim::SweepGrid grid;
+    grid.base.requests = 100;
+    grid.floors = {8, 12};
+    grid.elevators = {1, 3};
+    grid.rates = {0.5, 2};
+    grid.dispatches = {sim::FEWEST_REQUESTS, sim::LOWEST_ETA};
+    grid.seeds = 3;
+    return grid;
+  }
+}
+
+TEST(Sweep, grid) {
+  sim::SweepGrid grid = small_grid();
+  ASSERT_EQ(48, grid.size());
+  // Seeds vary fastest, then dispatches, ..., then floors.
+  EXPECT_EQ(grid.base.seed + 2, grid.at(2).seed);
+  EXPECT_EQ(sim::LOWEST_ETA, grid.at(3).dispatch);
+  EXPECT_EQ(2, grid.at(6).rate);
+  EXPECT_EQ(3, grid.at(12).elevators);
+  EXPECT_EQ(12, grid.at(24).floors);
+  sim::Scenario last = grid.at(47);
+  EXPECT_EQ(12, last.floors);
+  EXPECT_EQ(3, last.elevators);
+  EXPECT_EQ(2, last.rate);
+  EXPECT_EQ(sim::LOWEST_ETA, last.dispatch);
+  // Axes which aren't swept keep the base value.
+  EXPECT_EQ(grid.base.pattern, last.pattern);
+  EXPECT_EQ(100, last.requests);
+
+  sim::SweepGrid single;
+  EXPECT_EQ(1, single.size());
+  EXPECT_EQ(single.base.floors, single.at(0).floors);
+}
+
+TEST(Sweep, run_and_resume) {
+  sim::verbose_enabled = false;
+  char path[] = "/tmp/test-sweep-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_LE(0, fd);
+  close(fd);
+
+  sim::SweepGrid grid = small_grid();
+  sim::SweepFile file;
+  ASSERT_TRUE(file.create(path, grid));
+  EXPECT_EQ(grid.size(), file.size());
+  EXPECT_EQ(0, file.done_count());
+  EXPECT_EQ(12, file.column<uint32_t>(sim::COLUMN_FLOORS)[24]);
+
+  sim::SweepRunner runner(2);
+  size_t checkpoints = 0;
+  ASSERT_TRUE(runner.run(grid, file,
+          [&checkpoints](size_t done, size_t total) { ++checkpoints; }, 10));
+  EXPECT_EQ(5, checkpoints);
+  EXPECT_EQ(grid.size(), file.done_count());
+  // Each thread reuses its Scheduler until the building changes, which is
+  // every 12 runs.
+  EXPECT_LE(4, runner.schedulers().created());
+  EXPECT_GT(grid.size() / 2, runner.schedulers().created());
+
+  // Every run matches running its scenario alone.
+  for (size_t run = 0; run < grid.size(); ++run) {
+    sim::LatencyStats latency;
+    sim::RunResult result = sim::run_scenario(grid.at(run), &latency);
+    EXPECT_EQ(result.ticks, file.column<uint64_t>(sim::COLUMN_TICKS)[run]);
+    EXPECT_EQ(result.inserted,
+        file.column<uint64_t>(sim::COLUMN_INSERTED)[run]);
+    EXPECT_EQ(latency.wait.max(),
+        file.column<uint64_t>(sim::COLUMN_WAIT_MAX)[run]);
+    EXPECT_EQ(latency.travel.mean(),
+        file.column<double>(sim::COLUMN_TRAVEL_MEAN)[run]);
+  }
+  std::vector<uint64_t> ticks(file.column<uint64_t>(sim::COLUMN_TICKS),
+      file.column<uint64_t>(sim::COLUMN_TICKS) + file.size());
+
+  // As if the sweep had been killed partway: only the missing runs are
+  // redone, and come out the same.
+  for (size_t run = 5; run < grid.size(); run += 4) {
+    file.clear(run);
+  }
+  ASSERT_TRUE(file.close());
+  ASSERT_TRUE(file.resume(path, grid));
+  EXPECT_EQ(grid.size() - 11, file.done_count());
+  size_t first_done = 0;
+  ASSERT_TRUE(runner.run(grid, file,
+          [&first_done](size_t done, size_t total) {
+            if (first_done == 0) {
+              first_done = done;
+            }
+          }));
+  EXPECT_EQ(grid.size(), first_done);
+  EXPECT_EQ(grid.size(), file.done_count());
+  for (size_t run = 0; run < grid.size(); ++run) {
+    EXPECT_EQ(ticks[run], file.column<uint64_t>(sim::COLUMN_TICKS)[run]);
+  }
+  ASSERT_TRUE(file.close());
+
+  // The file can't be resumed with a different grid, but can be read.
+  sim::SweepGrid other = grid;
+  other.rates[1] = 3;
+  EXPECT_FALSE(file.resume(path, other));
+  other = grid;
+  other.seeds = 4;
+  EXPECT_FALSE(file.resume(path, other));
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(grid.size(), file.header().runs);
+  EXPECT_EQ(100, file.header().requests);
+  EXPECT_EQ(grid.size(), file.done_count());
+  file.close();
+  unlink(path);
+}
+
+TEST(Sweep, invalid_file) {
+  char path[] = "/tmp/test-sweep-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(5, write(fd, "hello", 5));
+  close(fd);
+  sim::SweepFile file;
+  EXPECT_FALSE(file.open(path));
+  EXPECT_FALSE(file.resume(path, small_grid()));
+  unlink(path);
+  EXPECT_FALSE(file.open(path));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "sim/thread_pool.h"
+
+TEST(ThreadPool, single_thread) {
+  sim::ThreadPool p(1);
+  EXPECT_EQ(1, p.size());
+  std::vector<int> hits(100, 0);
+  p.parallel_for(hits.size(), [&hits](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++hits[i];
+    }
+  });
+  for (int hit : hits) {
+    EXPECT_EQ(1, hit);
+  }
+}
+
+TEST(ThreadPool, every_index_once) {
+  sim::ThreadPool p(4);
+  EXPECT_EQ(4, p.size());
+  std::vector<std::atomic<int>> hits(10000);
+  for (size_t round = 0; round < 50; ++round) {
+    for (std::atomic<int> &hit : hits) {
+      hit = 0;
+    }
+    p.parallel_for(hits.size(), [&hits](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        ++hits[i];
+      }
+    }, 7);
+    for (std::atomic<int> &hit : hits) {
+      ASSERT_EQ(1, hit);
+    }
+  }
+}
+
+TEST(ThreadPool, uneven_work) {
+  sim::ThreadPool p(4);
+  std::atomic<size_t> sum(0);
+  // Nearly all of the work is at the front, so other threads must steal it.
+  p.parallel_for(64, [&sum](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (i < 16) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      sum += i;
+    }
+  });
+  EXPECT_EQ(64 * 63 / 2, sum);
+}
+
+TEST(ThreadPool, slots) {
+  sim::ThreadPool p(4);
+  std::vector<std::atomic<int>> busy(p.size());
+  std::atomic<size_t> sum(0);
+  bool overlapped = false, out_of_range = false;
+  p.parallel_for_slots(200, [&](size_t slot, size_t begin, size_t end) {
+    if (slot >= busy.size()) {
+      out_of_range = true;
+      return;
+    }
+    // No other task holds this slot while this one runs.
+    if (busy[slot]++ != 0) {
+      overlapped = true;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      sum += i;
+    }
+    --busy[slot];
+  });
+  EXPECT_FALSE(out_of_range);
+  EXPECT_FALSE(overlapped);
+  EXPECT_EQ(200 * 199 / 2, sum);
+}
+
+TEST(ThreadPool, empty) {
+  sim::ThreadPool p(3);
+  p.parallel_for(0, [](size_t begin, size_t end) {
+    FAIL();
+  });
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include "sim/logging.h"
+#include "sim/scheduler.h"
+#include "sim/trace.h"
+
+namespace {
+  /**
+   * A scheduler which provides access to its internal state.
+   */
+  class TestScheduler : public sim::Scheduler {
+   public:
+    TestScheduler(sim::floor_t floors, size_t elevators)
+      : sim::Scheduler(floors, elevators) { }
+
+    std::vector<sim::Elevator> &peek_elevators() {
+      return elevators;
+    }
+  };
+
+  std::string trace_path(const char *name) {
+    return std::string(::testing::TempDir()) + name;
+  }
+}
+
+TEST(Trace, missing_file) {
+  sim::TraceReader reader;
+  EXPECT_FALSE(reader.open(trace_path("does-not-exist.trace").c_str()));
+}
+
+TEST(Trace, write_read) {
+  std::string path = trace_path("write-read.trace");
+  sim::TraceWriter writer;
+  ASSERT_TRUE(writer.open(path.c_str(), 10, 2));
+  for (uint32_t i = 0; i < 10000; ++i) {
+    writer.record(sim::TRACE_REQUEST, i / 3, 0, i % 10, (i + 1) % 10);
+  }
+  ASSERT_TRUE(writer.close());
+
+  sim::TraceReader reader;
+  ASSERT_TRUE(reader.open(path.c_str()));
+  EXPECT_EQ(10, reader.header().floors);
+  EXPECT_EQ(2, reader.header().elevators);
+  ASSERT_EQ(10000, reader.size());
+  EXPECT_EQ(sim::TRACE_REQUEST, reader[5].type);
+  EXPECT_EQ(1, reader[5].tick);
+  EXPECT_EQ(5, reader[5].a);
+  EXPECT_EQ(6, reader[5].b);
+  EXPECT_EQ(0, reader.find(0));
+  EXPECT_EQ(3, reader.find(1));
+  EXPECT_EQ(30, reader.find(10));
+  EXPECT_EQ(10000, reader.find(5000));
+}
+
+TEST(Trace, replay_matches_scheduler) {
+  sim::verbose_enabled = false;
+  std::string path = trace_path("replay.trace");
+  const sim::floor_t floors = 30;
+  const size_t elevators = 4;
+  TestScheduler s(floors, elevators);
+  sim::TraceWriter writer;
+  ASSERT_TRUE(writer.open(path.c_str(), floors, elevators));
+  s.set_trace(&writer);
+  srand(5);
+  for (size_t i = 0; i < 500; ++i) {
+    s.insert_request(rand() % floors, rand() % floors);
+    s.tick();
+  }
+  // Some skipped travel, too.
+  s.schedule_request(2000, 0, floors - 1);
+  s.run_until(2500);
+  ASSERT_TRUE(writer.close());
+
+  sim::TraceReader reader;
+  ASSERT_TRUE(reader.open(path.c_str()));
+  sim::TraceState state(floors, elevators);
+  for (size_t i = 0; i < reader.size(); ++i) {
+    ASSERT_TRUE(state.apply(reader[i])) << "record " << i;
+  }
+  for (size_t i = 0; i < elevators; ++i) {
+    sim::Elevator &expected = s.peek_elevators()[i];
+    EXPECT_EQ(expected.floor(), state.elevators[i].floor());
+    EXPECT_EQ(expected.direction(), state.elevators[i].direction());
+    EXPECT_EQ(expected.request_count(), state.elevators[i].request_count());
+  }
+}
+
+TEST(Trace, state_hashes) {
+  sim::verbose_enabled = false;
+  std::string path = trace_path("hashes.trace");
+  const sim::floor_t floors = 20;
+  const size_t elevators = 3;
+  TestScheduler s(floors, elevators);
+  sim::TraceWriter writer;
+  ASSERT_TRUE(writer.open(path.c_str(), floors, elevators));
+  s.set_trace(&writer);
+  srand(6);
+  for (size_t i = 0; i < 100; ++i) {
+    s.insert_request(rand() % floors, rand() % floors);
+    s.tick();
+  }
+  s.schedule_request(500, 0, floors - 1);
+  s.run_until(600);
+  ASSERT_TRUE(writer.close());
+
+  // One hash for each tick, or run of skipped ticks, in order.
+  sim::TraceReader reader;
+  ASSERT_TRUE(reader.open(path.c_str()));
+  sim::TraceState state(floors, elevators);
+  size_t hashes = 0, last_tick = 0;
+  uint64_t last_hash = 0;
+  for (size_t i = 0; i < reader.size(); ++i) {
+    const sim::TraceRecord &record = reader[i];
+    ASSERT_TRUE(state.apply(record)) << "record " << i;
+    if (record.type == sim::TRACE_HASH) {
+      EXPECT_LT(last_tick, record.tick);
+      last_tick = record.tick;
+      last_hash = record.a | (uint64_t(record.b) << 32);
+      ++hashes;
+    }
+  }
+  EXPECT_LE(100, hashes);
+  EXPECT_GT(s.tick_count(), hashes);
+  EXPECT_EQ(s.tick_count(), last_tick);
+  EXPECT_EQ(s.state_hash(), last_hash);
+}
+
+TEST(Trace, replay_detects_mismatch) {
+  sim::TraceState state(10, 1);
+  sim::TraceRecord pickup = {1, 0, 5, sim::Direction::UP, sim::TRACE_PICKUP,
+    {0, 0, 0}};
+  EXPECT_TRUE(state.apply(pickup));
+  // The elevator would move up towards floor 5, not down.
+  sim::TraceRecord action = {1, 0, 0, sim::Action::FLOOR_DOWN,
+    sim::TRACE_ACTION, {0, 0, 0}};
+  EXPECT_FALSE(state.apply(action));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
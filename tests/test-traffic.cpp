@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "sim/random.h"
+#include "sim/traffic.h"
+
+TEST(Traffic, random_stream) {
+  sim::RandomStream stream(42);
+  sim::RandomStream copy(42);
+  for (uint64_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(stream.at(i), copy.next());
+  }
+  EXPECT_EQ(100, copy.counter());
+
+  // Children are independent of each other and of their parent.
+  sim::RandomStream a = stream.split(1), b = stream.split(2);
+  EXPECT_NE(a.at(0), b.at(0));
+  EXPECT_NE(a.at(0), stream.at(0));
+  EXPECT_EQ(a.at(5), stream.split(1).at(5));
+  EXPECT_NE(sim::RandomStream(43).split(1).at(0), a.at(0));
+
+  for (size_t i = 0; i < 1000; ++i) {
+    EXPECT_GT(7, a.below(7));
+  }
+}
+
+TEST(Traffic, pattern_names) {
+  const sim::Pattern ALL[] = {
+    sim::INTER_FLOOR, sim::UP_PEAK, sim::DOWN_PEAK, sim::LUNCH};
+  for (sim::Pattern pattern : ALL) {
+    sim::Pattern parsed = sim::INTER_FLOOR;
+    EXPECT_TRUE(sim::parse_pattern(sim::string(pattern), parsed));
+    EXPECT_EQ(pattern, parsed);
+  }
+  sim::Pattern parsed;
+  EXPECT_FALSE(sim::parse_pattern("uniform", parsed));
+}
+
+TEST(Traffic, poisson_rate) {
+  // Both a single table and one split into parts.
+  const double RATES[] = {0.1, 2.5, 100};
+  for (double rate : RATES) {
+    sim::TrafficGenerator traffic(20, sim::INTER_FLOOR, rate, 7);
+    std::vector<sim::Request> requests;
+    const size_t TICKS = 20000;
+    double sum_squares = 0;
+    for (size_t tick = 1; tick <= TICKS; ++tick) {
+      size_t count = traffic.generate(tick, requests);
+      sum_squares += double(count) * count;
+    }
+    double mean = double(requests.size()) / TICKS;
+    double variance = sum_squares / TICKS - mean * mean;
+    EXPECT_NEAR(rate, mean, rate * 0.03);
+    EXPECT_NEAR(rate, variance, rate * 0.05);
+  }
+  sim::TrafficGenerator none(20, sim::INTER_FLOOR, 0, 7, 10);
+  sim::Request out[4];
+  EXPECT_EQ(0, none.read(out, 4));
+}
+
+TEST(Traffic, patterns) {
+  const sim::floor_t floors = 30;
+  const size_t COUNT = 100000;
+  const sim::Pattern ALL[] = {
+    sim::INTER_FLOOR, sim::UP_PEAK, sim::DOWN_PEAK, sim::LUNCH};
+  for (sim::Pattern pattern : ALL) {
+    sim::TrafficGenerator traffic(floors, pattern, 3, 11, COUNT);
+    std::vector<sim::Request> requests(COUNT);
+    ASSERT_EQ(COUNT, traffic.read(requests.data(), COUNT));
+    size_t from_lobby = 0, to_lobby = 0;
+    for (const sim::Request &request : requests) {
+      EXPECT_GT(floors, request.source);
+      EXPECT_GT(floors, request.dest);
+      EXPECT_NE(request.source, request.dest);
+      from_lobby += (request.source == 0);
+      to_lobby += (request.dest == 0);
+    }
+    double from = double(from_lobby) / COUNT, to = double(to_lobby) / COUNT;
+    switch (pattern) {
+      case sim::INTER_FLOOR:
+        EXPECT_NEAR(1.0 / floors, from, 0.01);
+        EXPECT_NEAR(1.0 / floors, to, 0.01);
+        break;
+      case sim::UP_PEAK:
+        EXPECT_NEAR(0.9, from, 0.01);
+        break;
+      case sim::DOWN_PEAK:
+        EXPECT_NEAR(0.9, to, 0.01);
+        break;
+      case sim::LUNCH:
+        EXPECT_NEAR(0.45, from, 0.01);
+        EXPECT_NEAR(0.45, to, 0.01);
+        break;
+    }
+  }
+}
+
+TEST(Traffic, reproducible) {
+  // The same requests come out of read() in any chunk size, and of
+  // generate() for each tick in any order or on any thread.
+  const size_t COUNT = 5000;
+  sim::TrafficGenerator whole(40, sim::LUNCH, 1.5, 3, COUNT);
+  std::vector<sim::Request> expected(COUNT + 1);
+  ASSERT_EQ(COUNT, whole.read(expected.data(), COUNT + 1));
+  EXPECT_EQ(0, whole.read(expected.data(), COUNT + 1));
+  expected.resize(COUNT);
+  EXPECT_LE(1, expected.front().tick);
+
+  sim::TrafficGenerator chunked(40, sim::LUNCH, 1.5, 3, COUNT);
+  std::vector<sim::Request> requests;
+  sim::Request chunk[7];
+  size_t count;
+  while ((count = chunked.read(chunk, 7)) != 0) {
+    requests.insert(requests.end(), chunk, chunk + count);
+  }
+  ASSERT_EQ(COUNT, requests.size());
+  for (size_t i = 0; i < COUNT; ++i) {
+    EXPECT_EQ(expected[i].tick, requests[i].tick);
+    EXPECT_EQ(expected[i].source, requests[i].source);
+    EXPECT_EQ(expected[i].dest, requests[i].dest);
+  }
+
+  // Split the ticks between two threads, back to front.
+  size_t ticks = expected.back().tick;
+  std::vector<sim::Request> halves[2];
+  auto run = [&whole, &halves, ticks](size_t half) {
+    std::vector<sim::Request> reversed;
+    for (size_t tick = ticks; tick >= 1; --tick) {
+      if (tick % 2 == half) {
+        std::vector<sim::Request> one;
+        whole.generate(tick, one);
+        reversed.insert(reversed.begin(), one.begin(), one.end());
+      }
+    }
+    halves[half] = reversed;
+  };
+  std::thread even(run, 0), odd(run, 1);
+  even.join();
+  odd.join();
+  size_t next[2] = {0, 0};
+  for (size_t i = 0; i < COUNT; ++i) {
+    size_t half = expected[i].tick % 2;
+    ASSERT_LT(next[half], halves[half].size());
+    const sim::Request &request = halves[half][next[half]++];
+    EXPECT_EQ(expected[i].tick, request.tick);
+    EXPECT_EQ(expected[i].source, request.source);
+    EXPECT_EQ(expected[i].dest, request.dest);
+  }
+}
+
+TEST(Traffic, known_values) {
+  // Any change to these breaks reproducibility of recorded runs.
+  EXPECT_EQ(0xe220a8397b1dcdafULL, sim::RandomStream(0).at(0));
+  EXPECT_EQ(0x71f4f39ae89502a0ULL, sim::RandomStream(1).split(2).at(3));
+  sim::TrafficGenerator traffic(100, sim::UP_PEAK, 4, 9);
+  std::vector<sim::Request> requests;
+  traffic.generate(1000, requests);
+  ASSERT_EQ(4, requests.size());
+  EXPECT_EQ(0, requests[0].source);
+  EXPECT_EQ(6, requests[0].dest);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
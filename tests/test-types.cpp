@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "sim/types.h"
+
+TEST(FloorSet, empty) {
+  sim::FloorSet s(10);
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(0, s.size());
+  EXPECT_FALSE(s.contains(0));
+  EXPECT_FALSE(s.erase(3));
+  EXPECT_TRUE(s.begin() == s.end());
+}
+
+TEST(FloorSet, insert_erase) {
+  sim::FloorSet s(10);
+  EXPECT_TRUE(s.insert(3));
+  EXPECT_FALSE(s.insert(3));
+  EXPECT_TRUE(s.insert(7));
+  EXPECT_EQ(2, s.size());
+  EXPECT_TRUE(s.contains(3));
+  EXPECT_FALSE(s.contains(4));
+  EXPECT_EQ(3, s.first());
+  EXPECT_EQ(7, s.last());
+
+  EXPECT_TRUE(s.erase(3));
+  EXPECT_FALSE(s.erase(3));
+  EXPECT_EQ(1, s.size());
+  EXPECT_EQ(7, s.first());
+  EXPECT_EQ(7, s.last());
+
+  s.clear();
+  EXPECT_TRUE(s.empty());
+  EXPECT_FALSE(s.contains(7));
+}
+
+TEST(FloorSet, multiple_words) {
+  sim::FloorSet s(200);
+  EXPECT_TRUE(s.insert(199));
+  EXPECT_TRUE(s.insert(64));
+  EXPECT_TRUE(s.insert(63));
+  EXPECT_TRUE(s.insert(130));
+  EXPECT_EQ(63, s.first());
+  EXPECT_EQ(199, s.last());
+  EXPECT_EQ(64, s.next(64));
+  EXPECT_EQ(130, s.next(65));
+  EXPECT_EQ(s.end_floor(), s.next(200));
+
+  std::vector<sim::floor_t> floors;
+  for (sim::floor_t floor : s) {
+    floors.push_back(floor);
+  }
+  ASSERT_EQ(4, floors.size());
+  EXPECT_EQ(63, floors[0]);
+  EXPECT_EQ(64, floors[1]);
+  EXPECT_EQ(130, floors[2]);
+  EXPECT_EQ(199, floors[3]);
+}
+
+TEST(FloorSet, previous_count_below) {
+  sim::FloorSet s(200);
+  EXPECT_EQ(s.end_floor(), s.previous(199));
+  EXPECT_EQ(0, s.count_below(199));
+  EXPECT_TRUE(s.insert(3));
+  EXPECT_TRUE(s.insert(64));
+  EXPECT_TRUE(s.insert(130));
+  EXPECT_EQ(130, s.previous(199));
+  EXPECT_EQ(130, s.previous(500));
+  EXPECT_EQ(64, s.previous(129));
+  EXPECT_EQ(64, s.previous(64));
+  EXPECT_EQ(3, s.previous(63));
+  EXPECT_EQ(s.end_floor(), s.previous(2));
+
+  EXPECT_EQ(0, s.count_below(3));
+  EXPECT_EQ(1, s.count_below(4));
+  EXPECT_EQ(1, s.count_below(64));
+  EXPECT_EQ(2, s.count_below(65));
+  EXPECT_EQ(3, s.count_below(131));
+  EXPECT_EQ(3, s.count_below(1000));
+}
+
+TEST(FloorSet, grow_past_capacity) {
+  sim::FloorSet s;
+  EXPECT_TRUE(s.insert(100));
+  EXPECT_TRUE(s.insert(2));
+  EXPECT_EQ(2, s.first());
+  EXPECT_EQ(100, s.last());
+  EXPECT_TRUE(s.contains(100));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}
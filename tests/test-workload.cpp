@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "sim/logging.h"
+#include "sim/workload.h"
+
+namespace {
+  std::string temp_path(const char *name) {
+    return std::string(::testing::TempDir()) + name;
+  }
+
+  void write_file(const std::string &path, const char *content) {
+    FILE *file = fopen(path.c_str(), "w");
+    fputs(content, file);
+    fclose(file);
+  }
+}
+
+TEST(Workload, csv) {
+  std::string path = temp_path("workload.csv");
+  write_file(path, "tick,source,dest\n1,0,4\n\n3, 2, 1\n# comment\n7,5,6");
+
+  sim::CsvRequestSource source;
+  ASSERT_TRUE(source.open(path.c_str()));
+  sim::Request requests[10];
+  ASSERT_EQ(3, source.read(requests, 10));
+  EXPECT_EQ(1, requests[0].tick);
+  EXPECT_EQ(0, requests[0].source);
+  EXPECT_EQ(4, requests[0].dest);
+  EXPECT_EQ(3, requests[1].tick);
+  EXPECT_EQ(2, requests[1].source);
+  EXPECT_EQ(1, requests[1].dest);
+  EXPECT_EQ(7, requests[2].tick);
+  EXPECT_EQ(5, requests[2].source);
+  EXPECT_EQ(6, requests[2].dest);
+  EXPECT_EQ(0, source.read(requests, 10));
+}
+
+TEST(Workload, csv_many_chunks) {
+  std::string path = temp_path("workload-big.csv");
+  FILE *file = fopen(path.c_str(), "w");
+  for (size_t i = 0; i < 200000; ++i) {
+    fprintf(file, "%lu,%lu,%lu\n", i, i % 50, (i + 1) % 50);
+  }
+  fclose(file);
+
+  std::unique_ptr<sim::RequestSource> source =
+    sim::open_request_source(path.c_str());
+  ASSERT_TRUE(source.get() != NULL);
+  std::vector<sim::Request> requests(1000);
+  size_t total = 0;
+  for (size_t count; (count = source->read(requests.data(), 1000)) > 0;) {
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_EQ(total + i, requests[i].tick);
+      ASSERT_EQ((total + i) % 50, requests[i].source);
+    }
+    total += count;
+  }
+  EXPECT_EQ(200000, total);
+}
+
+TEST(Workload, binary) {
+  std::string path = temp_path("workload.bin");
+  sim::BinaryRequestWriter writer;
+  ASSERT_TRUE(writer.open(path.c_str()));
+  for (size_t i = 0; i < 10000; ++i) {
+    ASSERT_TRUE(writer.write(sim::Request(i / 2, i % 7, i % 11)));
+  }
+  ASSERT_TRUE(writer.close());
+
+  std::unique_ptr<sim::RequestSource> source =
+    sim::open_request_source(path.c_str());
+  ASSERT_TRUE(source.get() != NULL);
+  std::vector<sim::Request> requests(3000);
+  size_t total = 0;
+  for (size_t count; (count = source->read(requests.data(), 3000)) > 0;) {
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_EQ((total + i) / 2, requests[i].tick);
+      ASSERT_EQ((total + i) % 7, requests[i].source);
+      ASSERT_EQ((total + i) % 11, requests[i].dest);
+    }
+    total += count;
+  }
+  EXPECT_EQ(10000, total);
+}
+
+TEST(Workload, feeder_matches_schedule) {
+  sim::verbose_enabled = false;
+  std::string path = temp_path("workload-feed.bin");
+  sim::BinaryRequestWriter writer;
+  ASSERT_TRUE(writer.open(path.c_str()));
+  sim::Scheduler scheduled(20, 3), fed(20, 3);
+  srand(6);
+  size_t tick = 1;
+  for (size_t i = 0; i < 1000; ++i) {
+    tick += rand() % 3;
+    sim::Request request(tick, rand() % 20, rand() % 20);
+    writer.write(request);
+    scheduled.schedule_request(request.tick, request.source, request.dest);
+  }
+  ASSERT_TRUE(writer.close());
+
+  std::unique_ptr<sim::RequestSource> source =
+    sim::open_request_source(path.c_str());
+  ASSERT_TRUE(source.get() != NULL);
+  // Small batches, to exercise refilling.
+  sim::RequestFeeder feeder(*source, 7);
+  while (!feeder.done()) {
+    feeder.insert_due(fed);
+    fed.tick();
+    scheduled.tick();
+    ASSERT_EQ(scheduled.stats().pending_dests, fed.stats().pending_dests);
+    ASSERT_EQ(scheduled.stats().elevator_requests,
+        fed.stats().elevator_requests);
+  }
+  EXPECT_EQ(tick, fed.tick_count());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest( &argc, argv );
+  return RUN_ALL_TESTS();
+}